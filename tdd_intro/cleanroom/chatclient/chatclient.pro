@@ -8,7 +8,22 @@ CONFIG -= qt
 SOURCES += \
     test.cpp \
     socketwrapper.cpp \
-    socketwrappertest.cpp
+    socketwrappertest.cpp \
+    sessionpool.cpp \
+    sessionpooltest.cpp \
+    socketrecorder.cpp \
+    socketrecordertest.cpp \
+    chathistoryindex.cpp \
+    chathistoryindextest.cpp \
+    sharedring.cpp \
+    sharedringtest.cpp \
+    sharedmemorysocketwrapper.cpp \
+    chatprotocol.cpp \
+    chatprotocoltest.cpp \
+    latencyhistogram.cpp \
+    latencyhistogramtest.cpp \
+    reliabledelivery.cpp \
+    reliabledeliverytest.cpp
 
 LIBS += \
     Ws2_32.lib \
@@ -19,4 +34,12 @@ HEADERS += \
     socketwrapper.h \
     mocks.h \
     isocketwrapper.h \
-    igui.h
+    igui.h \
+    sessionpool.h \
+    socketrecorder.h \
+    chathistoryindex.h \
+    sharedring.h \
+    sharedmemorysocketwrapper.h \
+    chatprotocol.h \
+    latencyhistogram.h \
+    reliabledelivery.h
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "chathistoryindex.h"
+
+namespace
+{
+    const size_t s_skipInterval = 64;
+
+    bool IsTermChar(unsigned char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+    }
+
+    char FoldCase(unsigned char c)
+    {
+        return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+
+    std::vector<std::string> SplitTerms(const std::string& text)
+    {
+        std::vector<std::string> terms;
+        std::string term;
+        for (char c : text)
+        {
+            if (IsTermChar(static_cast<unsigned char>(c)))
+            {
+                term += FoldCase(static_cast<unsigned char>(c));
+            }
+            else if (!term.empty())
+            {
+                terms.push_back(term);
+                term.clear();
+            }
+        }
+        if (!term.empty())
+        {
+            terms.push_back(term);
+        }
+        return terms;
+    }
+
+    void AppendVarint(std::string& bytes, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        bytes += static_cast<char>(value);
+    }
+}
+
+class ChatHistoryIndex::PostingIterator
+{
+public:
+    explicit PostingIterator(const PostingList& list)
+        : m_list(list)
+        , m_position(list.deltas.data())
+        , m_end(list.deltas.data() + list.deltas.size())
+        , m_current(0)
+        , m_valid(true)
+    {
+        Next();
+    }
+
+    bool Valid() const { return m_valid; }
+    MessageId Current() const { return m_current; }
+
+    void Next()
+    {
+        if (m_position == m_end)
+        {
+            m_valid = false;
+            return;
+        }
+
+        uint64_t delta = 0;
+        for (int shift = 0; ; shift += 7)
+        {
+            unsigned char byte = static_cast<unsigned char>(*m_position++);
+            delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                break;
+            }
+        }
+        m_current += delta;
+    }
+
+    // Moves to the first id not less than target.
+    void SkipTo(MessageId target)
+    {
+        if (!m_valid || m_current >= target)
+        {
+            return;
+        }
+
+        // Jumps to the last skip entry not after target, then decodes at most s_skipInterval postings.
+        auto skip = std::upper_bound(m_list.skips.begin(), m_list.skips.end(), target,
+                                     [](MessageId id, const Skip& entry) { return id < entry.id; });
+        if (skip != m_list.skips.begin() && (skip - 1)->id > m_current)
+        {
+            --skip;
+            m_current = skip->id;
+            m_position = m_list.deltas.data() + skip->offset;
+        }
+        while (m_valid && m_current < target)
+        {
+            Next();
+        }
+    }
+
+private:
+    const PostingList& m_list;
+    const char* m_position;
+    const char* m_end;
+    MessageId m_current;
+    bool m_valid;
+};
+
+ChatHistoryIndex::ChatHistoryIndex()
+    : m_messageCount(0)
+    , m_lastId(0)
+{
+}
+
+void ChatHistoryIndex::Add(MessageId id, const std::string& text)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_messageCount && id <= m_lastId)
+    {
+        throw std::invalid_argument("Message ids must grow.");
+    }
+
+    std::vector<std::string> terms = SplitTerms(text);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    for (const std::string& term : terms)
+    {
+        PostingList& list = m_postings[term];
+        // The first delta is the id itself, so an empty list starts from 0.
+        AppendVarint(list.deltas, id - list.last);
+        list.last = id;
+        if (++list.count % s_skipInterval == 0)
+        {
+            list.skips.push_back(Skip{id, list.deltas.size()});
+        }
+    }
+
+    m_lastId = id;
+    ++m_messageCount;
+}
+
+ChatHistoryIndex::MessageIds ChatHistoryIndex::FindAll(const std::vector<std::string>& terms) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<const PostingList*> lists;
+    for (const std::string& term : terms)
+    {
+        const PostingList* list = Find(term);
+        if (!list)
+        {
+            return MessageIds();
+        }
+        lists.push_back(list);
+    }
+    if (lists.empty())
+    {
+        return MessageIds();
+    }
+
+    // The rarest term drives the intersection.
+    std::sort(lists.begin(), lists.end(), [](const PostingList* left, const PostingList* right)
+    {
+        return left->count < right->count;
+    });
+    std::vector<PostingIterator> iterators;
+    for (const PostingList* list : lists)
+    {
+        iterators.emplace_back(*list);
+    }
+
+    MessageIds result;
+    PostingIterator& lead = iterators.front();
+    while (lead.Valid())
+    {
+        MessageId candidate = lead.Current();
+        bool found = true;
+        for (size_t i = 1; i < iterators.size(); ++i)
+        {
+            iterators[i].SkipTo(candidate);
+            if (!iterators[i].Valid())
+            {
+                return result;
+            }
+            if (iterators[i].Current() != candidate)
+            {
+                lead.SkipTo(iterators[i].Current());
+                found = false;
+                break;
+            }
+        }
+        if (found)
+        {
+            result.push_back(candidate);
+            lead.Next();
+        }
+    }
+    return result;
+}
+
+ChatHistoryIndex::MessageIds ChatHistoryIndex::FindAny(const std::vector<std::string>& terms) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<PostingIterator> iterators;
+    for (const std::string& term : terms)
+    {
+        if (const PostingList* list = Find(term))
+        {
+            iterators.emplace_back(*list);
+        }
+    }
+
+    MessageIds result;
+    for (;;)
+    {
+        bool any = false;
+        MessageId smallest = 0;
+        for (const PostingIterator& iterator : iterators)
+        {
+            if (iterator.Valid() && (!any || iterator.Current() < smallest))
+            {
+                smallest = iterator.Current();
+                any = true;
+            }
+        }
+        if (!any)
+        {
+            return result;
+        }
+
+        result.push_back(smallest);
+        for (PostingIterator& iterator : iterators)
+        {
+            if (iterator.Valid() && iterator.Current() == smallest)
+            {
+                iterator.Next();
+            }
+        }
+    }
+}
+
+size_t ChatHistoryIndex::MessageCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_messageCount;
+}
+
+size_t ChatHistoryIndex::TermCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_postings.size();
+}
+
+size_t ChatHistoryIndex::PostingBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = 0;
+    for (const auto& posting : m_postings)
+    {
+        bytes += posting.second.deltas.size();
+    }
+    return bytes;
+}
+
+const ChatHistoryIndex::PostingList* ChatHistoryIndex::Find(const std::string& term) const
+{
+    std::vector<std::string> folded = SplitTerms(term);
+    if (folded.size() != 1)
+    {
+        return nullptr;
+    }
+    auto found = m_postings.find(folded.front());
+    return found == m_postings.end() ? nullptr : &found->second;
+}
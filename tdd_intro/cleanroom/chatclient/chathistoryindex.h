@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ *  Incremental full-text index over chat history.
+ *
+ * Every received message is added with its id, ids must grow. Each term maps to a posting list
+ * of message ids, stored as varint-encoded deltas, so a posting costs one or two bytes
+ * for a busy chat. Queries decode posting lists on the fly and never materialize
+ * more than the result. Every 64th posting of a list is also recorded in a skip list
+ * with its byte offset, so an AND query jumps over long runs of a common term
+ * instead of decoding them.
+ *
+ * The index is guarded by a mutex: messages may be added while other threads search.
+ *
+ * Terms are runs of letters and digits, ASCII letters are case-folded. Bytes above 0x7F
+ * are treated as letters, so UTF-8 words are kept whole.
+*/
+
+class ChatHistoryIndex
+{
+public:
+    using MessageId = uint64_t;
+    using MessageIds = std::vector<MessageId>;
+
+    ChatHistoryIndex();
+
+    // Indexes the message text. Throws std::invalid_argument if id is not greater than the previous one.
+    void Add(MessageId id, const std::string& text);
+
+    // Returns ids of messages that contain all terms, in ascending order.
+    MessageIds FindAll(const std::vector<std::string>& terms) const;
+    // Returns ids of messages that contain at least one of terms, in ascending order.
+    MessageIds FindAny(const std::vector<std::string>& terms) const;
+
+    size_t MessageCount() const;
+    size_t TermCount() const;
+    // Size of all encoded posting lists, without skip lists.
+    size_t PostingBytes() const;
+
+private:
+    // Posting with its position in the encoded list: decoding may resume right after it.
+    struct Skip
+    {
+        MessageId id;
+        size_t offset;
+    };
+
+    struct PostingList
+    {
+        std::string deltas;
+        std::vector<Skip> skips;
+        MessageId last = 0;
+        size_t count = 0;
+    };
+
+    class PostingIterator;
+
+    const PostingList* Find(const std::string& term) const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, PostingList> m_postings;
+    size_t m_messageCount;
+    MessageId m_lastId;
+};
@@ -0,0 +1,106 @@
+// Tests for full-text search over chat history.
+#include <gmock/gmock.h>
+#include <thread>
+#include "chathistoryindex.h"
+
+using namespace testing;
+
+TEST(ChatHistoryIndexTest, FindsMessagesWithAllTerms)
+{
+    ChatHistoryIndex index;
+    index.Add(1, "Disk is full on relay-3");
+    index.Add(2, "relay-3 restarted");
+    index.Add(5, "DISK alarm, relay-4");
+
+    EXPECT_THAT(index.FindAll({"disk", "relay"}), ElementsAre(1, 5));
+    EXPECT_THAT(index.FindAll({"relay", "3"}), ElementsAre(1, 2));
+    EXPECT_THAT(index.FindAll({"disk", "restarted"}), IsEmpty());
+    EXPECT_THAT(index.FindAll({"unknown"}), IsEmpty());
+}
+
+TEST(ChatHistoryIndexTest, FindsMessagesWithAnyTerm)
+{
+    ChatHistoryIndex index;
+    index.Add(1, "Disk is full");
+    index.Add(2, "restarted");
+    index.Add(3, "nothing interesting");
+    index.Add(300, "disk replaced, restarted");
+
+    EXPECT_THAT(index.FindAny({"Disk", "restarted", "unknown"}), ElementsAre(1, 2, 300));
+}
+
+TEST(ChatHistoryIndexTest, RejectsIdsOutOfOrder)
+{
+    ChatHistoryIndex index;
+    index.Add(10, "hello");
+    EXPECT_THROW(index.Add(10, "hello"), std::invalid_argument);
+}
+
+TEST(ChatHistoryIndexTest, PostingsAreDeltaEncoded)
+{
+    ChatHistoryIndex index;
+    for (ChatHistoryIndex::MessageId id = 1000000; id < 1001000; ++id)
+    {
+        index.Add(id, "ping ping");
+    }
+
+    EXPECT_EQ(1, index.TermCount());
+    EXPECT_EQ(1000, index.MessageCount());
+    // The first id takes three bytes, every next one is a single byte delta.
+    EXPECT_EQ(3 + 999, index.PostingBytes());
+    EXPECT_EQ(1000, index.FindAll({"ping"}).size());
+}
+
+TEST(ChatHistoryIndexTest, IntersectsRareAndCommonTermsAcrossSkips)
+{
+    ChatHistoryIndex index;
+    ChatHistoryIndex::MessageIds everyTenth;
+    ChatHistoryIndex::MessageIds every64th;
+    for (ChatHistoryIndex::MessageId id = 1; id <= 100000; ++id)
+    {
+        std::string text = "common";
+        if (id % 10 == 0)
+        {
+            text += " tenth";
+            everyTenth.push_back(id);
+        }
+        if (id % 64 == 0)
+        {
+            // Lands exactly on skip entries of "common".
+            text += " aligned";
+            every64th.push_back(id);
+        }
+        if (id == 99999)
+        {
+            text += " rare";
+        }
+        index.Add(id, text);
+    }
+
+    EXPECT_THAT(index.FindAll({"common", "rare"}), ElementsAre(99999));
+    EXPECT_EQ(everyTenth, index.FindAll({"tenth", "common"}));
+    EXPECT_EQ(every64th, index.FindAll({"common", "aligned"}));
+    EXPECT_THAT(index.FindAll({"aligned", "tenth", "common"}), Each(Truly([](ChatHistoryIndex::MessageId id) { return id % 320 == 0; })));
+    EXPECT_EQ(100000 / 320, index.FindAll({"aligned", "tenth", "common"}).size());
+}
+
+TEST(ChatHistoryIndexTest, SearchesWhileMessagesAreAdded)
+{
+    ChatHistoryIndex index;
+    std::thread writer([&index]()
+    {
+        for (ChatHistoryIndex::MessageId id = 1; id <= 20000; ++id)
+        {
+            index.Add(id, "status ok");
+        }
+    });
+    size_t found = 0;
+    while (found < 20000)
+    {
+        const size_t next = index.FindAll({"status", "ok"}).size();
+        EXPECT_GE(next, found);
+        found = next;
+    }
+    writer.join();
+    EXPECT_EQ(20000, index.MessageCount());
+}
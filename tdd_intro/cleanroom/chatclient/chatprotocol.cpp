@@ -0,0 +1,251 @@
+#include <algorithm>
+
+#include "chatprotocol.h"
+#include "latencyhistogram.h"
+
+namespace
+{
+    const std::string s_helloMagic = ":HELLO!";
+    const std::string s_batchMark = ":BATCH";
+    const std::string s_timeMark = ":TIME";
+    const std::string s_reliableMark = ":RELIABLE";
+    const char s_messageEnd = '\0';
+    const char s_timestampMark = '\x01';
+    const char s_timestampEnd = ':';
+
+    bool EndsWith(const std::string& text, const std::string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+std::string MakeHello(const Hello& hello)
+{
+    return hello.nickname + s_helloMagic +
+           (hello.batching ? s_batchMark : std::string()) +
+           (hello.timestamps ? s_timeMark : std::string()) +
+           (hello.reliable ? s_reliableMark : std::string());
+}
+
+bool ParseHello(const std::string& message, Hello& hello)
+{
+    std::string rest = message;
+    hello.batching = false;
+    hello.timestamps = false;
+    hello.reliable = false;
+    for (;;)
+    {
+        if (EndsWith(rest, s_batchMark))
+        {
+            hello.batching = true;
+            rest.resize(rest.size() - s_batchMark.size());
+        }
+        else if (EndsWith(rest, s_timeMark))
+        {
+            hello.timestamps = true;
+            rest.resize(rest.size() - s_timeMark.size());
+        }
+        else if (EndsWith(rest, s_reliableMark))
+        {
+            hello.reliable = true;
+            rest.resize(rest.size() - s_reliableMark.size());
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (!EndsWith(rest, s_helloMagic) || rest.size() == s_helloMagic.size())
+    {
+        return false;
+    }
+    hello.nickname = rest.substr(0, rest.size() - s_helloMagic.size());
+    return true;
+}
+
+uint64_t TimestampNow()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+std::string StampMessage(const std::string& text, uint64_t timestamp)
+{
+    return s_timestampMark + std::to_string(timestamp) + s_timestampEnd + text;
+}
+
+bool UnstampMessage(std::string& message, uint64_t& timestamp)
+{
+    if (message.empty() || message[0] != s_timestampMark)
+    {
+        return false;
+    }
+    size_t end = message.find(s_timestampEnd, 1);
+    if (end == std::string::npos || end == 1)
+    {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (size_t i = 1; i < end; ++i)
+    {
+        if (message[i] < '0' || message[i] > '9')
+        {
+            return false;
+        }
+        value = value * 10 + static_cast<uint64_t>(message[i] - '0');
+    }
+    timestamp = value;
+    message.erase(0, end + 1);
+    return true;
+}
+
+MessageSender::MessageSender(ISocketWrapper& socket, BatchPolicy policy, Clock clock)
+    : m_socket(socket)
+    , m_policy(policy)
+    , m_clock(clock)
+    , m_timestamps(false)
+    , m_pendingCount(0)
+{
+}
+
+void MessageSender::SetPolicy(BatchPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FlushLocked();
+    m_policy = policy;
+}
+
+void MessageSender::SetTimestamps(bool timestamps)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timestamps = timestamps;
+}
+
+void MessageSender::Send(const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_pendingCount)
+    {
+        m_firstQueued = m_clock();
+    }
+    m_batch += m_timestamps ? StampMessage(message, TimestampNow()) : message;
+    m_batch += s_messageEnd;
+    ++m_pendingCount;
+
+    if (m_batch.size() >= m_policy.maxBytes)
+    {
+        FlushLocked();
+        return;
+    }
+    FlushIfDueLocked();
+}
+
+void MessageSender::FlushIfDue()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FlushIfDueLocked();
+}
+
+void MessageSender::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FlushLocked();
+}
+
+size_t MessageSender::Pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pendingCount;
+}
+
+void MessageSender::FlushIfDueLocked()
+{
+    if (m_pendingCount && m_clock() - m_firstQueued >= m_policy.maxDelay)
+    {
+        FlushLocked();
+    }
+}
+
+void MessageSender::FlushLocked()
+{
+    if (!m_pendingCount)
+    {
+        return;
+    }
+    m_socket.Write(m_batch);
+    m_batch.clear();
+    m_pendingCount = 0;
+}
+
+BatchFlusher::BatchFlusher(MessageSender& sender, std::chrono::microseconds period)
+    : m_sender(sender)
+    , m_period(period)
+    , m_stop(false)
+    , m_thread(&BatchFlusher::Run, this)
+{
+}
+
+BatchFlusher::~BatchFlusher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_stopped.notify_one();
+    m_thread.join();
+}
+
+void BatchFlusher::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopped.wait_for(lock, m_period, [this]() { return m_stop; }))
+    {
+        // A flush may block in a socket write while the peer stalls:
+        // the lock is released, so stopping is not held up by it.
+        lock.unlock();
+        m_sender.FlushIfDue();
+        lock.lock();
+    }
+}
+
+MessageReceiver::MessageReceiver(ISocketWrapper& socket, size_t readSize)
+    : m_socket(socket)
+    , m_buffer(readSize)
+    , m_timestamps(false)
+    , m_latency(nullptr)
+{
+}
+
+bool MessageReceiver::Receive(std::vector<std::string>& messages)
+{
+    size_t received = m_socket.Read(m_buffer.data(), m_buffer.size());
+    if (!received)
+    {
+        return false;
+    }
+
+    const uint64_t now = m_latency ? TimestampNow() : 0;
+    const char* position = m_buffer.data();
+    const char* end = position + received;
+    for (;;)
+    {
+        const char* messageEnd = std::find(position, end, s_messageEnd);
+        if (messageEnd == end)
+        {
+            break;
+        }
+        m_partial.append(position, messageEnd);
+        messages.push_back(std::string());
+        messages.back().swap(m_partial);
+        position = messageEnd + 1;
+
+        uint64_t sent = 0;
+        if (m_timestamps && UnstampMessage(messages.back(), sent) && m_latency)
+        {
+            m_latency->Record(now > sent ? now - sent : 0);
+        }
+    }
+    m_partial.append(position, end);
+    return true;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "isocketwrapper.h"
+
+/*
+ *  Chat wire protocol.
+ *
+ * Every message, handshake included, ends with '\0' byte.
+ * Handshake is "<nickname>:HELLO!" followed by options the peer supports:
+ * ":BATCH" for batching, ":TIME" for send timestamps and ":RELIABLE" for reliable delivery (see reliabledelivery.h).
+ * An option is used only when both peers have announced it.
+ *
+ * With batching on, MessageSender packs queued messages into one socket write until
+ * the batch grows to maxBytes or its first message waits for maxDelay; BatchFlusher writes
+ * overdue batches when nothing more is sent. A batch is the same bytes as its messages
+ * sent one by one, so ":BATCH" doesn't change the framing: it is the consent of the peer
+ * to wait up to maxDelay for its messages. A latency-sensitive peer leaves it out.
+ * MessageReceiver unpacks all messages of a read in one pass.
+ *
+ * With timestamps on, every message starts with '\x01', the sender wall clock time
+ * in microseconds and ':', so the receiver can record end-to-end latency.
+*/
+
+class LatencyHistogram;
+
+struct Hello
+{
+    std::string nickname;
+    bool batching = false;
+    bool timestamps = false;
+    bool reliable = false;
+};
+
+// Builds handshake message, without the trailing '\0'.
+std::string MakeHello(const Hello& hello);
+// Returns false if message is not a valid handshake.
+bool ParseHello(const std::string& message, Hello& hello);
+
+// Microseconds of wall clock, the time base of message timestamps.
+uint64_t TimestampNow();
+// Prepends send timestamp to the message text.
+std::string StampMessage(const std::string& text, uint64_t timestamp);
+// Removes send timestamp from the message. Returns false if the message has no timestamp.
+bool UnstampMessage(std::string& message, uint64_t& timestamp);
+
+struct BatchPolicy
+{
+    // Size of batch that is written immediately. 0 turns batching off.
+    size_t maxBytes = 0;
+    // Longest time the first queued message may wait for others.
+    std::chrono::microseconds maxDelay = std::chrono::microseconds(0);
+
+    static BatchPolicy Disabled() { return BatchPolicy(); }
+};
+
+class MessageSender
+{
+public:
+    using Clock = std::function<std::chrono::steady_clock::time_point()>;
+
+    MessageSender(ISocketWrapper& socket, BatchPolicy policy, Clock clock = std::chrono::steady_clock::now);
+
+    // Changes batching, e.g. after the handshake. Flushes messages queued so far.
+    void SetPolicy(BatchPolicy policy);
+    // Turns send timestamps on or off, off by default.
+    void SetTimestamps(bool timestamps);
+    // Queues message, writes the batch if it's full or overdue.
+    void Send(const std::string& message);
+    // Writes the batch if its first message waits for maxDelay.
+    // Called by BatchFlusher, so may be called from another thread than Send.
+    void FlushIfDue();
+    // Writes all queued messages.
+    void Flush();
+
+    size_t Pending() const;
+
+private:
+    void FlushIfDueLocked();
+    void FlushLocked();
+
+private:
+    mutable std::mutex m_mutex;
+    ISocketWrapper& m_socket;
+    BatchPolicy m_policy;
+    Clock m_clock;
+    bool m_timestamps;
+    std::string m_batch;
+    size_t m_pendingCount;
+    std::chrono::steady_clock::time_point m_firstQueued;
+};
+
+// Flushes overdue batches of the sender from its own thread, every period,
+// so a message waits at most maxDelay + period even if nothing is sent after it.
+class BatchFlusher
+{
+public:
+    BatchFlusher(MessageSender& sender, std::chrono::microseconds period);
+    ~BatchFlusher();
+
+private:
+    void Run();
+
+private:
+    MessageSender& m_sender;
+    std::chrono::microseconds m_period;
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    bool m_stop;
+    std::thread m_thread;
+};
+
+class MessageReceiver
+{
+public:
+    explicit MessageReceiver(ISocketWrapper& socket, size_t readSize = 64 * 1024);
+
+    // Turns removing of send timestamps on or off, off by default.
+    void SetTimestamps(bool timestamps) { m_timestamps = timestamps; }
+    // Latency of stamped messages is recorded to histogram. nullptr turns it off.
+    void SetLatencyHistogram(LatencyHistogram* histogram) { m_latency = histogram; }
+
+    // Reads the socket once and appends all complete messages to messages.
+    // A message split between reads is kept until its end arrives.
+    // Returns false when the connection is closed by the other side.
+    bool Receive(std::vector<std::string>& messages);
+
+private:
+    ISocketWrapper& m_socket;
+    std::vector<char> m_buffer;
+    std::string m_partial;
+    bool m_timestamps;
+    LatencyHistogram* m_latency;
+};
@@ -0,0 +1,191 @@
+// Tests for the chat wire protocol.
+#include <gtest/gtest.h>
+#include "mocks.h"
+#include "chatprotocol.h"
+#include "latencyhistogram.h"
+
+using namespace testing;
+
+namespace
+{
+    std::string Frame(const std::string& data)
+    {
+        return std::string(data.c_str(), data.size() + 1);
+    }
+
+    ACTION_P(ReadChunk, chunk)
+    {
+        std::copy(chunk.begin(), chunk.end(), arg0);
+        return chunk.size();
+    }
+}
+
+TEST(ChatProtocolTest, HelloWithoutOptions)
+{
+    Hello hello;
+    hello.nickname = "metizik";
+    EXPECT_EQ("metizik:HELLO!", MakeHello(hello));
+
+    Hello parsed;
+    ASSERT_TRUE(ParseHello("user:HELLO!", parsed));
+    EXPECT_EQ("user", parsed.nickname);
+    EXPECT_FALSE(parsed.batching);
+    EXPECT_FALSE(parsed.timestamps);
+    EXPECT_FALSE(parsed.reliable);
+}
+
+TEST(ChatProtocolTest, HelloWithBatching)
+{
+    Hello hello;
+    hello.nickname = "metizik";
+    hello.batching = true;
+
+    Hello parsed;
+    ASSERT_TRUE(ParseHello(MakeHello(hello), parsed));
+    EXPECT_EQ("metizik", parsed.nickname);
+    EXPECT_TRUE(parsed.batching);
+}
+
+TEST(ChatProtocolTest, MalformedHello)
+{
+    Hello parsed;
+    EXPECT_FALSE(ParseHello("user:HI!", parsed));
+    EXPECT_FALSE(ParseHello(":HELLO!", parsed));
+    EXPECT_FALSE(ParseHello("user:BATCH", parsed));
+}
+
+TEST(ChatProtocolTest, SendsEachMessageWhenBatchingIsOff)
+{
+    SocketWrapperMock socket;
+    MessageSender sender(socket, BatchPolicy::Disabled());
+
+    InSequence sequence;
+    EXPECT_CALL(socket, Write(Frame("Hello!")));
+    EXPECT_CALL(socket, Write(Frame("Bye!")));
+
+    sender.Send("Hello!");
+    sender.Send("Bye!");
+}
+
+TEST(ChatProtocolTest, PacksMessagesUntilBatchIsFull)
+{
+    SocketWrapperMock socket;
+    auto now = std::chrono::steady_clock::now();
+    BatchPolicy policy;
+    policy.maxBytes = 8;
+    policy.maxDelay = std::chrono::milliseconds(5);
+    MessageSender sender(socket, policy, [&now]() { return now; });
+
+    EXPECT_CALL(socket, Write(Frame("ab") + Frame("cd") + Frame("ef")));
+    sender.Send("ab");
+    sender.Send("cd");
+    EXPECT_EQ(2, sender.Pending());
+    sender.Send("ef");
+    EXPECT_EQ(0, sender.Pending());
+}
+
+TEST(ChatProtocolTest, FlushesBatchAfterDelay)
+{
+    SocketWrapperMock socket;
+    auto now = std::chrono::steady_clock::now();
+    BatchPolicy policy;
+    policy.maxBytes = 1024;
+    policy.maxDelay = std::chrono::milliseconds(5);
+    MessageSender sender(socket, policy, [&now]() { return now; });
+
+    sender.Send("ab");
+    now += std::chrono::milliseconds(4);
+    sender.FlushIfDue();
+
+    EXPECT_CALL(socket, Write(Frame("ab") + Frame("cd")));
+    now += std::chrono::milliseconds(1);
+    sender.Send("cd");
+}
+
+TEST(ChatProtocolTest, FlusherWritesOverdueBatch)
+{
+    SocketWrapperMock socket;
+    BatchPolicy policy;
+    policy.maxBytes = 1024;
+    policy.maxDelay = std::chrono::milliseconds(1);
+    MessageSender sender(socket, policy);
+
+    std::mutex mutex;
+    std::condition_variable written;
+    bool done = false;
+    EXPECT_CALL(socket, Write(Frame("ab"))).WillOnce(InvokeWithoutArgs([&]()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        written.notify_one();
+    }));
+
+    BatchFlusher flusher(sender, std::chrono::milliseconds(1));
+    sender.Send("ab");
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(written.wait_for(lock, std::chrono::seconds(10), [&done]() { return done; }));
+}
+
+TEST(ChatProtocolTest, UnpacksAllMessagesOfRead)
+{
+    SocketWrapperMock socket;
+    MessageReceiver receiver(socket);
+
+    EXPECT_CALL(socket, Read(_, _))
+        .WillOnce(ReadChunk(Frame("Hello!") + Frame("How are") + "yo"))
+        .WillOnce(ReadChunk(Frame("u?")))
+        .WillOnce(Return(0));
+
+    std::vector<std::string> messages;
+    EXPECT_TRUE(receiver.Receive(messages));
+    EXPECT_EQ(std::vector<std::string>({"Hello!", "How are"}), messages);
+
+    EXPECT_TRUE(receiver.Receive(messages));
+    EXPECT_EQ(std::vector<std::string>({"Hello!", "How are", "you?"}), messages);
+
+    EXPECT_FALSE(receiver.Receive(messages));
+}
+
+TEST(ChatProtocolTest, HelloWithAllOptions)
+{
+    Hello hello;
+    hello.nickname = "metizik";
+    hello.batching = true;
+    hello.timestamps = true;
+    hello.reliable = true;
+
+    Hello parsed;
+    ASSERT_TRUE(ParseHello(MakeHello(hello), parsed));
+    EXPECT_EQ("metizik", parsed.nickname);
+    EXPECT_TRUE(parsed.batching);
+    EXPECT_TRUE(parsed.timestamps);
+    EXPECT_TRUE(parsed.reliable);
+}
+
+TEST(ChatProtocolTest, StampedMessage)
+{
+    std::string message = StampMessage("Hello!", 1234567);
+    uint64_t timestamp = 0;
+    ASSERT_TRUE(UnstampMessage(message, timestamp));
+    EXPECT_EQ(1234567, timestamp);
+    EXPECT_EQ("Hello!", message);
+
+    EXPECT_FALSE(UnstampMessage(message, timestamp));
+}
+
+TEST(ChatProtocolTest, RecordsLatencyOfStampedMessages)
+{
+    SocketWrapperMock socket;
+    MessageReceiver receiver(socket);
+    LatencyHistogram latency;
+    receiver.SetTimestamps(true);
+    receiver.SetLatencyHistogram(&latency);
+
+    EXPECT_CALL(socket, Read(_, _))
+        .WillOnce(ReadChunk(Frame(StampMessage("Hello!", TimestampNow())) + Frame("Not stamped")));
+
+    std::vector<std::string> messages;
+    EXPECT_TRUE(receiver.Receive(messages));
+    EXPECT_EQ(std::vector<std::string>({"Hello!", "Not stamped"}), messages);
+    EXPECT_EQ(1, latency.Count());
+}
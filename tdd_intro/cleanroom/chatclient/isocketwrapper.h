@@ -31,6 +31,9 @@ public:
     virtual ISocketWrapperPtr Connect(const std::string& addr, int16_t port)= 0;
     // Reads all available data from the stream of established connection.
     virtual void Read(std::string& buffer)= 0;
+    // Reads available data straight into caller-owned memory, at most size bytes.
+    // Returns the number of bytes read. Use it to fill a ring buffer or an arena without an intermediate copy.
+    virtual size_t Read(char* buffer, size_t size)= 0;
     // Writes data to the stream of established connection.
     // Note, that this function succeeds when write operation is done:
     // it doesn't check whether the data was successfully received on the other side.
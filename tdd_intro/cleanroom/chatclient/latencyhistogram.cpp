@@ -0,0 +1,155 @@
+#include <sstream>
+
+#include "latencyhistogram.h"
+
+namespace
+{
+    const int s_subBucketBits = 7;
+    const uint64_t s_subBucketCount = 1ull << s_subBucketBits;
+    const int s_maxValueBits = 40;
+
+    int HighestBit(uint64_t value)
+    {
+        int bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+}
+
+const uint64_t LatencyHistogram::MaxValue = (1ull << s_maxValueBits) - 1;
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(BucketIndex(MaxValue) + 1)
+    , m_count(0)
+    , m_max(0)
+{
+    Reset();
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    if (value > MaxValue)
+    {
+        value = MaxValue;
+    }
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds latency)
+{
+    Record(static_cast<uint64_t>(latency.count() > 0 ? latency.count() : 0));
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const
+{
+    const uint64_t count = Count();
+    if (!count)
+    {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+    if (target < 1)
+    {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t index = 0; index < m_buckets.size(); ++index)
+    {
+        seen += m_buckets[index].load(std::memory_order_relaxed);
+        if (seen >= target)
+        {
+            uint64_t value = BucketHighestValue(index);
+            return value < Max() ? value : Max();
+        }
+    }
+    return Max();
+}
+
+std::string LatencyHistogram::Summary() const
+{
+    std::ostringstream summary;
+    summary << "count=" << Count()
+            << " p50=" << Percentile(50)
+            << " p90=" << Percentile(90)
+            << " p99=" << Percentile(99)
+            << " p999=" << Percentile(99.9)
+            << " max=" << Max();
+    return summary.str();
+}
+
+void LatencyHistogram::Reset()
+{
+    for (std::atomic<uint64_t>& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t value)
+{
+    // Values below 2 * s_subBucketCount get a bucket each, every next power of two range
+    // is split into s_subBucketCount buckets by its top bits.
+    if (value < 2 * s_subBucketCount)
+    {
+        return static_cast<size_t>(value);
+    }
+    const int shift = HighestBit(value) - s_subBucketBits;
+    return static_cast<size_t>(shift * s_subBucketCount + (value >> shift));
+}
+
+uint64_t LatencyHistogram::BucketHighestValue(size_t index)
+{
+    if (index < 2 * s_subBucketCount)
+    {
+        return index;
+    }
+    const uint64_t shift = index / s_subBucketCount - 1;
+    const uint64_t mantissa = index - shift * s_subBucketCount;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyReporter::LatencyReporter(LatencyHistogram& histogram, std::chrono::milliseconds period, Sink sink, bool resetAfterDump)
+    : m_histogram(histogram)
+    , m_period(period)
+    , m_sink(sink)
+    , m_resetAfterDump(resetAfterDump)
+    , m_stop(false)
+    , m_thread(&LatencyReporter::Run, this)
+{
+}
+
+LatencyReporter::~LatencyReporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_stopped.notify_one();
+    m_thread.join();
+}
+
+void LatencyReporter::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopped.wait_for(lock, m_period, [this]() { return m_stop; }))
+    {
+        m_sink(m_histogram.Summary());
+        if (m_resetAfterDump)
+        {
+            m_histogram.Reset();
+        }
+    }
+}
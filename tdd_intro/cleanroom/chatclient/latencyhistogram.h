@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ *  HDR-style latency histogram.
+ *
+ * Values are counted in log-linear buckets: every power of two range is split into 128 buckets,
+ * so a reported value is within 1% of the recorded one. Memory is fixed (about 35KB for values
+ * up to 2^40 microseconds) and Record is lock-free, so any number of threads may record
+ * while another one reads percentiles.
+*/
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    // Records one value, values above MaxValue are counted as MaxValue.
+    void Record(uint64_t value);
+    void Record(std::chrono::microseconds latency);
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+    // Returns the smallest recorded value not exceeded by percentile% of records, 0 when empty.
+    uint64_t Percentile(double percentile) const;
+    // "count=... p50=... p90=... p99=... p999=... max=..." in microseconds.
+    std::string Summary() const;
+    void Reset();
+
+    static const uint64_t MaxValue;
+
+private:
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketHighestValue(size_t index);
+
+private:
+    std::vector<std::atomic<uint64_t>> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_max;
+};
+
+// Periodically dumps the histogram summary to sink from its own thread.
+class LatencyReporter
+{
+public:
+    using Sink = std::function<void(const std::string&)>;
+
+    // When resetAfterDump is set every dump covers only the last period.
+    LatencyReporter(LatencyHistogram& histogram, std::chrono::milliseconds period, Sink sink, bool resetAfterDump = false);
+    ~LatencyReporter();
+
+private:
+    void Run();
+
+private:
+    LatencyHistogram& m_histogram;
+    std::chrono::milliseconds m_period;
+    Sink m_sink;
+    bool m_resetAfterDump;
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    bool m_stop;
+    std::thread m_thread;
+};
@@ -0,0 +1,95 @@
+// Tests for the latency histogram.
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "latencyhistogram.h"
+
+TEST(LatencyHistogramTest, EmptyHistogram)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.Count());
+    EXPECT_EQ(0, histogram.Percentile(99));
+    EXPECT_EQ("count=0 p50=0 p90=0 p99=0 p999=0 max=0", histogram.Summary());
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact)
+{
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 100; ++value)
+    {
+        histogram.Record(value);
+    }
+
+    EXPECT_EQ(100, histogram.Count());
+    EXPECT_EQ(50, histogram.Percentile(50));
+    EXPECT_EQ(90, histogram.Percentile(90));
+    EXPECT_EQ(99, histogram.Percentile(99));
+    EXPECT_EQ(100, histogram.Percentile(100));
+    EXPECT_EQ(100, histogram.Max());
+}
+
+TEST(LatencyHistogramTest, LargeValuesWithinOnePercent)
+{
+    LatencyHistogram histogram;
+    for (uint64_t value = 1000; value <= 1000000; value += 1000)
+    {
+        histogram.Record(value);
+    }
+
+    EXPECT_NEAR(500000, histogram.Percentile(50), 5000);
+    EXPECT_NEAR(990000, histogram.Percentile(99), 9900);
+    EXPECT_EQ(1000000, histogram.Max());
+}
+
+TEST(LatencyHistogramTest, ClampsHugeValues)
+{
+    LatencyHistogram histogram;
+    histogram.Record(std::chrono::microseconds(-5));
+    histogram.Record(~0ull);
+
+    EXPECT_EQ(0, histogram.Percentile(50));
+    EXPECT_EQ(LatencyHistogram::MaxValue, histogram.Percentile(100));
+}
+
+TEST(LatencyHistogramTest, RecordsFromManyThreads)
+{
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&histogram]()
+        {
+            for (uint64_t value = 0; value < 10000; ++value)
+            {
+                histogram.Record(value);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(40000, histogram.Count());
+    EXPECT_EQ(9999, histogram.Max());
+}
+
+TEST(LatencyHistogramTest, ReporterDumpsPeriodically)
+{
+    LatencyHistogram histogram;
+    histogram.Record(42);
+
+    std::vector<std::string> dumps;
+    std::mutex mutex;
+    {
+        LatencyReporter reporter(histogram, std::chrono::milliseconds(1), [&](const std::string& summary)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            dumps.push_back(summary);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    ASSERT_FALSE(dumps.empty());
+    EXPECT_EQ("count=1 p50=42 p90=42 p99=42 p999=42 max=42", dumps.front());
+}
@@ -11,6 +11,7 @@ public:
     MOCK_METHOD0(Accept, ISocketWrapperPtr());
     MOCK_METHOD2(Connect, ISocketWrapperPtr(const std::string& addr, int16_t port));
     MOCK_METHOD1(Read, void(std::string& buffer));
+    MOCK_METHOD2(Read, size_t(char* buffer, size_t size));
     MOCK_METHOD1(Write, void(const std::string& buffer));
 };
 
@@ -0,0 +1,112 @@
+#include <stdexcept>
+
+#include "reliabledelivery.h"
+
+namespace
+{
+    const char s_dataMark = '\x02';
+    const char s_ackMark = '\x06';
+    const char s_sequenceEnd = ':';
+
+    // Parses decimal digits of text from position till end. Returns false if there are none or other characters.
+    bool ParseSequence(const std::string& text, size_t position, size_t end, uint64_t& sequence)
+    {
+        if (position >= end)
+        {
+            return false;
+        }
+        uint64_t value = 0;
+        for (size_t i = position; i < end; ++i)
+        {
+            if (text[i] < '0' || text[i] > '9')
+            {
+                return false;
+            }
+            value = value * 10 + static_cast<uint64_t>(text[i] - '0');
+        }
+        sequence = value;
+        return true;
+    }
+}
+
+ReliableSender::ReliableSender(size_t capacity)
+    : m_capacity(capacity ? capacity : 1)
+    , m_nextSequence(1)
+{
+}
+
+std::string ReliableSender::Wrap(const std::string& text)
+{
+    Entry entry;
+    entry.sequence = m_nextSequence++;
+    entry.message = s_dataMark + std::to_string(entry.sequence) + s_sequenceEnd + text;
+
+    if (m_ring.size() == m_capacity)
+    {
+        m_ring.pop_front();
+    }
+    m_ring.push_back(entry);
+    return m_ring.back().message;
+}
+
+void ReliableSender::OnAck(uint64_t sequence)
+{
+    while (!m_ring.empty() && m_ring.front().sequence <= sequence)
+    {
+        m_ring.pop_front();
+    }
+}
+
+std::vector<std::string> ReliableSender::Replay(uint64_t sequence) const
+{
+    if (sequence < LastSent() && (m_ring.empty() || m_ring.front().sequence > sequence + 1))
+    {
+        throw std::runtime_error("Messages after " + std::to_string(sequence) + " are not in the replay buffer anymore.");
+    }
+
+    std::vector<std::string> messages;
+    for (const Entry& entry : m_ring)
+    {
+        if (entry.sequence > sequence)
+        {
+            messages.push_back(entry.message);
+        }
+    }
+    return messages;
+}
+
+ReliableReceiver::ReliableReceiver(size_t ackEvery)
+    : m_ackEvery(ackEvery ? ackEvery : 1)
+    , m_unacknowledged(0)
+    , m_lastDelivered(0)
+{
+}
+
+ReliableReceiver::Kind ReliableReceiver::OnMessage(std::string& message, uint64_t& sequence)
+{
+    if (!message.empty() && message[0] == s_ackMark && ParseSequence(message, 1, message.size(), sequence))
+    {
+        return Kind::Ack;
+    }
+
+    size_t end = message.empty() || message[0] != s_dataMark ? std::string::npos : message.find(s_sequenceEnd);
+    if (end == std::string::npos || !ParseSequence(message, 1, end, sequence))
+    {
+        return Kind::Plain;
+    }
+    if (sequence <= m_lastDelivered)
+    {
+        return Kind::Duplicate;
+    }
+
+    message.erase(0, end + 1);
+    m_lastDelivered = sequence;
+    ++m_unacknowledged;
+    return Kind::Data;
+}
+
+std::string ReliableReceiver::MakeAck()
+{
+    m_unacknowledged = 0;
+    return s_ackMark + std::to_string(m_lastDelivered);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+ *  Reliable delivery across reconnects.
+ *
+ * Used when both peers announce ":RELIABLE" in the handshake.
+ * ReliableSender numbers every outgoing message ("\x02<sequence>:<text>") and keeps it
+ * in a bounded replay ring until the peer acknowledges it.
+ * ReliableReceiver drops duplicates and acknowledges delivered messages cumulatively
+ * ("\x06<last sequence>"), one ack per batch of messages rather than per message.
+ *
+ * After a reconnect each side sends its ack first, and the other side replays
+ * everything after it, so the session resumes instead of starting over.
+*/
+
+class ReliableSender
+{
+public:
+    // capacity is the number of unacknowledged messages kept for replay.
+    explicit ReliableSender(size_t capacity = 1024);
+
+    // Numbers the message and keeps it for replay. Returns the message to send.
+    // When the ring is full the oldest unacknowledged message is dropped.
+    std::string Wrap(const std::string& text);
+    // Drops all messages up to sequence from the replay ring.
+    void OnAck(uint64_t sequence);
+    // Returns messages to resend to a peer which has received everything up to sequence.
+    // Throws std::runtime_error if some of the messages are not in the ring anymore.
+    std::vector<std::string> Replay(uint64_t sequence) const;
+
+    uint64_t LastSent() const { return m_nextSequence - 1; }
+    size_t Unacknowledged() const { return m_ring.size(); }
+
+private:
+    struct Entry
+    {
+        uint64_t sequence;
+        std::string message;
+    };
+
+    size_t m_capacity;
+    uint64_t m_nextSequence;
+    std::deque<Entry> m_ring;
+};
+
+class ReliableReceiver
+{
+public:
+    enum class Kind
+    {
+        // New message, its text is left in the message.
+        Data,
+        // Message delivered before, it must be ignored.
+        Duplicate,
+        // Ack from the peer, its sequence is stored to sequence.
+        Ack,
+        // Message without reliable framing.
+        Plain
+    };
+
+    // An ack is due after ackEvery delivered messages.
+    explicit ReliableReceiver(size_t ackEvery = 32);
+
+    // Classifies the incoming message and strips its framing.
+    Kind OnMessage(std::string& message, uint64_t& sequence);
+
+    bool AckDue() const { return m_unacknowledged >= m_ackEvery; }
+    // True if some delivered messages are not acknowledged yet, e.g. to ack when the connection goes idle.
+    bool AckPending() const { return m_unacknowledged > 0; }
+    // Returns ack message for everything delivered so far.
+    std::string MakeAck();
+
+    uint64_t LastDelivered() const { return m_lastDelivered; }
+
+private:
+    size_t m_ackEvery;
+    size_t m_unacknowledged;
+    uint64_t m_lastDelivered;
+};
@@ -0,0 +1,104 @@
+// Tests for reliable delivery across reconnects.
+#include <gtest/gtest.h>
+#include "reliabledelivery.h"
+
+TEST(ReliableDeliveryTest, DeliversNumberedMessages)
+{
+    ReliableSender sender;
+    ReliableReceiver receiver;
+
+    std::string message = sender.Wrap("Hello!");
+    uint64_t sequence = 0;
+    EXPECT_EQ(ReliableReceiver::Kind::Data, receiver.OnMessage(message, sequence));
+    EXPECT_EQ("Hello!", message);
+    EXPECT_EQ(1, sequence);
+    EXPECT_EQ(1, receiver.LastDelivered());
+}
+
+TEST(ReliableDeliveryTest, DropsDuplicates)
+{
+    ReliableSender sender;
+    ReliableReceiver receiver;
+
+    const std::string wrapped = sender.Wrap("Hello!");
+    std::string message = wrapped;
+    uint64_t sequence = 0;
+    receiver.OnMessage(message, sequence);
+
+    message = wrapped;
+    EXPECT_EQ(ReliableReceiver::Kind::Duplicate, receiver.OnMessage(message, sequence));
+}
+
+TEST(ReliableDeliveryTest, PassesPlainMessages)
+{
+    ReliableReceiver receiver;
+    std::string message = "user:HELLO!";
+    uint64_t sequence = 0;
+    EXPECT_EQ(ReliableReceiver::Kind::Plain, receiver.OnMessage(message, sequence));
+    EXPECT_EQ("user:HELLO!", message);
+}
+
+TEST(ReliableDeliveryTest, AcksAreBatched)
+{
+    ReliableSender sender;
+    ReliableReceiver receiver(3);
+    uint64_t sequence = 0;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        std::string message = sender.Wrap("text");
+        receiver.OnMessage(message, sequence);
+    }
+    EXPECT_FALSE(receiver.AckDue());
+    EXPECT_TRUE(receiver.AckPending());
+
+    std::string message = sender.Wrap("text");
+    receiver.OnMessage(message, sequence);
+    EXPECT_TRUE(receiver.AckDue());
+
+    std::string ack = receiver.MakeAck();
+    EXPECT_FALSE(receiver.AckPending());
+
+    ReliableReceiver peer;
+    EXPECT_EQ(ReliableReceiver::Kind::Ack, peer.OnMessage(ack, sequence));
+    EXPECT_EQ(3, sequence);
+    sender.OnAck(sequence);
+    EXPECT_EQ(0, sender.Unacknowledged());
+}
+
+TEST(ReliableDeliveryTest, ReplaysUnacknowledgedAfterReconnect)
+{
+    ReliableSender sender;
+    ReliableReceiver receiver;
+    uint64_t sequence = 0;
+
+    std::string first = sender.Wrap("one");
+    receiver.OnMessage(first, sequence);
+    sender.Wrap("two");   // lost with the connection
+    sender.Wrap("three"); // lost with the connection
+
+    // The reconnected peer starts with its ack.
+    std::string ack = receiver.MakeAck();
+    ReliableReceiver().OnMessage(ack, sequence);
+    sender.OnAck(sequence);
+
+    std::vector<std::string> replay = sender.Replay(sequence);
+    ASSERT_EQ(2, replay.size());
+    EXPECT_EQ(ReliableReceiver::Kind::Data, receiver.OnMessage(replay[0], sequence));
+    EXPECT_EQ("two", replay[0]);
+    EXPECT_EQ(ReliableReceiver::Kind::Data, receiver.OnMessage(replay[1], sequence));
+    EXPECT_EQ("three", replay[1]);
+}
+
+TEST(ReliableDeliveryTest, ReplayFailsWhenRingOverflowed)
+{
+    ReliableSender sender(2);
+    sender.Wrap("one");
+    sender.Wrap("two");
+    sender.Wrap("three");
+
+    EXPECT_EQ(2, sender.Unacknowledged());
+    EXPECT_THROW(sender.Replay(0), std::runtime_error);
+    EXPECT_EQ(2, sender.Replay(1).size());
+    EXPECT_TRUE(sender.Replay(3).empty());
+}
@@ -0,0 +1,110 @@
+#include "sessionpool.h"
+
+namespace
+{
+    const size_t s_granularity = alignof(std::max_align_t);
+}
+
+SlabPool::SlabPool(size_t blockSize, size_t blocksPerSlab)
+    : m_blockSize((blockSize + s_granularity - 1) / s_granularity * s_granularity)
+    , m_blocksPerSlab(blocksPerSlab ? blocksPerSlab : 1)
+    , m_blocksInUse(0)
+    , m_freeList(nullptr)
+{
+}
+
+void* SlabPool::Allocate()
+{
+    if (!m_freeList)
+    {
+        AddSlab();
+    }
+    FreeBlock* block = m_freeList;
+    m_freeList = block->next;
+    ++m_blocksInUse;
+    return block;
+}
+
+void SlabPool::Deallocate(void* block)
+{
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = m_freeList;
+    m_freeList = freed;
+    --m_blocksInUse;
+}
+
+void SlabPool::AddSlab()
+{
+    const size_t slabSize = m_blockSize * m_blocksPerSlab;
+    // Block size is a multiple of the alignment, not of sizeof(max_align_t): round the slab up.
+    m_slabs.emplace_back(new std::max_align_t[(slabSize + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]);
+    char* slab = reinterpret_cast<char*>(m_slabs.back().get());
+
+    // Thread the new blocks onto the free list in address order.
+    for (size_t i = m_blocksPerSlab; i > 0; --i)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * m_blockSize);
+        block->next = m_freeList;
+        m_freeList = block;
+    }
+}
+
+SessionPool::SessionPool(size_t blocksPerSlab)
+    : m_blocksPerSlab(blocksPerSlab)
+{
+}
+
+SessionPool& SessionPool::Default()
+{
+    // Intentionally leaked: sockets held in static objects may be released after
+    // the function-local statics are destroyed.
+    static SessionPool* s_pool = new SessionPool;
+    return *s_pool;
+}
+
+void* SessionPool::Allocate(size_t size, size_t alignment)
+{
+    if (alignment > s_granularity)
+    {
+        return ::operator new(size);
+    }
+
+    const size_t sizeClass = SizeClass(size);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<SlabPool>& pool = m_pools[sizeClass];
+    if (!pool)
+    {
+        pool.reset(new SlabPool(sizeClass, m_blocksPerSlab));
+    }
+    return pool->Allocate();
+}
+
+void SessionPool::Deallocate(void* block, size_t size, size_t alignment)
+{
+    if (alignment > s_granularity)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pools.at(SizeClass(size))->Deallocate(block);
+}
+
+SessionPool::Stats SessionPool::GetStats() const
+{
+    Stats stats;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& pool : m_pools)
+    {
+        stats.objectsInUse += pool.second->BlocksInUse();
+        stats.bytesInUse += pool.second->BlocksInUse() * pool.second->BlockSize();
+        stats.bytesReserved += pool.second->BytesReserved();
+    }
+    return stats;
+}
+
+size_t SessionPool::SizeClass(size_t size)
+{
+    return (size + s_granularity - 1) / s_granularity * s_granularity;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/*
+ *  Slab allocator for connection and session objects.
+ *
+ * SlabPool hands out blocks of one fixed size carved from large slabs, so an accept storm
+ * costs a pointer pop per connection instead of a trip to the global heap.
+ * SessionPool keeps one SlabPool per size class and collects the accounting.
+ * PoolAllocator adapts SessionPool to std::allocate_shared, which places the object and
+ * its shared_ptr control block into a single pooled block.
+*/
+
+class SlabPool
+{
+public:
+    SlabPool(size_t blockSize, size_t blocksPerSlab);
+
+    void* Allocate();
+    void Deallocate(void* block);
+
+    size_t BlockSize() const { return m_blockSize; }
+    size_t BlocksInUse() const { return m_blocksInUse; }
+    size_t BytesReserved() const { return m_slabs.size() * m_blocksPerSlab * m_blockSize; }
+
+private:
+    void AddSlab();
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    size_t m_blockSize;
+    size_t m_blocksPerSlab;
+    size_t m_blocksInUse;
+    FreeBlock* m_freeList;
+    std::vector<std::unique_ptr<std::max_align_t[]>> m_slabs;
+};
+
+class SessionPool
+{
+public:
+    struct Stats
+    {
+        // Number of objects currently allocated from the pool (one per connection for sockets).
+        size_t objectsInUse = 0;
+        // Bytes handed out to live objects, including shared_ptr control blocks.
+        size_t bytesInUse = 0;
+        // Bytes held by slabs, whether used or not.
+        size_t bytesReserved = 0;
+
+        size_t BytesPerObject() const { return objectsInUse ? bytesInUse / objectsInUse : 0; }
+    };
+
+    explicit SessionPool(size_t blocksPerSlab = 64);
+
+    // Pool shared by all SocketWrapper connections.
+    static SessionPool& Default();
+
+    void* Allocate(size_t size, size_t alignment);
+    void Deallocate(void* block, size_t size, size_t alignment);
+    Stats GetStats() const;
+
+private:
+    static size_t SizeClass(size_t size);
+
+private:
+    mutable std::mutex m_mutex;
+    size_t m_blocksPerSlab;
+    std::map<size_t, std::unique_ptr<SlabPool>> m_pools;
+};
+
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(SessionPool& pool) : m_pool(&pool) { }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : m_pool(other.Pool()) { }
+
+    T* allocate(size_t n)
+    {
+        if (n != 1)
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(m_pool->Allocate(sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if (n != 1)
+        {
+            ::operator delete(p);
+            return;
+        }
+        m_pool->Deallocate(p, sizeof(T), alignof(T));
+    }
+
+    SessionPool* Pool() const { return m_pool; }
+
+private:
+    SessionPool* m_pool;
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& left, const PoolAllocator<U>& right)
+{
+    return left.Pool() == right.Pool();
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& left, const PoolAllocator<U>& right)
+{
+    return !(left == right);
+}
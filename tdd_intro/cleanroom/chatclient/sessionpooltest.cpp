@@ -0,0 +1,75 @@
+// Tests for the slab allocator used for connection objects.
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+#include "sessionpool.h"
+
+namespace
+{
+    struct Session
+    {
+        explicit Session(int id) : id(id) { }
+        int id;
+        char payload[100];
+    };
+}
+
+TEST(SlabPoolTest, ReusesReleasedBlock)
+{
+    SlabPool pool(sizeof(Session), 4);
+
+    void* first = pool.Allocate();
+    pool.Deallocate(first);
+
+    EXPECT_EQ(first, pool.Allocate());
+    EXPECT_EQ(1, pool.BlocksInUse());
+}
+
+TEST(SlabPoolTest, GrowsBySlab)
+{
+    SlabPool pool(sizeof(Session), 4);
+    for (int i = 0; i < 5; ++i)
+    {
+        pool.Allocate();
+    }
+
+    EXPECT_EQ(5, pool.BlocksInUse());
+    EXPECT_EQ(2 * 4 * pool.BlockSize(), pool.BytesReserved());
+}
+
+TEST(SlabPoolTest, OddSlabHoldsAllBlocks)
+{
+    // 48 * 3 bytes is not a whole number of max_align_t.
+    SlabPool pool(48, 3);
+    std::vector<char*> blocks;
+    for (int i = 0; i < 3; ++i)
+    {
+        blocks.push_back(static_cast<char*>(pool.Allocate()));
+        std::fill(blocks.back(), blocks.back() + pool.BlockSize(), static_cast<char>(i));
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(static_cast<char>(i), blocks[i][0]);
+        EXPECT_EQ(static_cast<char>(i), blocks[i][pool.BlockSize() - 1]);
+    }
+    EXPECT_EQ(3 * 48, pool.BytesReserved());
+}
+
+TEST(SessionPoolTest, AllocateSharedUsesPool)
+{
+    SessionPool pool;
+    {
+        auto first = std::allocate_shared<Session>(PoolAllocator<Session>(pool), 1);
+        auto second = std::allocate_shared<Session>(PoolAllocator<Session>(pool), 2);
+        EXPECT_EQ(2, second->id);
+
+        SessionPool::Stats stats = pool.GetStats();
+        EXPECT_EQ(2, stats.objectsInUse);
+        EXPECT_GE(stats.BytesPerObject(), sizeof(Session));
+        EXPECT_GE(stats.bytesReserved, stats.bytesInUse);
+    }
+
+    EXPECT_EQ(0, pool.GetStats().objectsInUse);
+    EXPECT_EQ(0, pool.GetStats().BytesPerObject());
+}
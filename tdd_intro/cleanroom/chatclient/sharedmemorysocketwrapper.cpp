@@ -0,0 +1,273 @@
+#define WIN32_LEAN_AND_MEAN
+
+#include <Windows.h>
+#include <atomic>
+#include <stdexcept>
+
+#include "sharedmemorysocketwrapper.h"
+#include "sharedring.h"
+
+namespace
+{
+    const uint32_t s_ringCapacity = 64 * 1024; // 64KB per direction
+    const size_t s_ringSize = (SharedRing::RequiredSize(s_ringCapacity) + 63) / 64 * 64;
+    // The block starts with the channel state, the rings follow it.
+    const size_t s_stateSize = 64;
+    const size_t s_blockSize = s_stateSize + 2 * s_ringSize;
+    const int s_clientToServer = 0;
+    const int s_serverToClient = 1;
+
+    // The block is visible by name as soon as it is created, but may be used only once
+    // the server has set it up. Zero filled memory of a new block reads as Initializing.
+    enum ChannelState : uint32_t
+    {
+        Initializing = 0,
+        Listening = 1,
+        Connected = 2
+    };
+
+    std::string GetExceptionString(const std::string& message, DWORD errorCode)
+    {
+        return message + " " + std::to_string(errorCode) + "\n";
+    }
+
+    std::string ObjectName(int16_t port, const std::string& suffix)
+    {
+        return "Local\\chatclient-" + std::to_string(port) + "-" + suffix;
+    }
+
+    // Auto-reset events: a signal set before the other side starts waiting is not lost.
+    HANDLE CreateChannelEvent(int16_t port, const std::string& suffix)
+    {
+        HANDLE event = CreateEventA(nullptr, FALSE, FALSE, ObjectName(port, suffix).c_str());
+        if (!event)
+        {
+            throw std::runtime_error(GetExceptionString("Failed to create event.", GetLastError()));
+        }
+        return event;
+    }
+}
+
+class SharedMemorySocketWrapper::Channel
+{
+public:
+    Channel(int16_t port, bool create)
+        : m_mapping(nullptr)
+        , m_view(nullptr)
+        , m_accept(nullptr)
+        , m_data()
+        , m_space()
+    {
+        const std::string mappingName = ObjectName(port, "shm");
+        if (create)
+        {
+            m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                           0, static_cast<DWORD>(s_blockSize), mappingName.c_str());
+            if (m_mapping && GetLastError() == ERROR_ALREADY_EXISTS)
+            {
+                CloseHandle(m_mapping);
+                throw std::runtime_error(GetExceptionString("Failed to bind socket to address.", ERROR_ALREADY_EXISTS));
+            }
+        }
+        else
+        {
+            m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str());
+        }
+        if (!m_mapping)
+        {
+            throw std::runtime_error(GetExceptionString(create ? "Failed to bind socket to address." : "Failed to connect to server.",
+                                                        GetLastError()));
+        }
+
+        m_view = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, s_blockSize));
+        if (!m_view)
+        {
+            DWORD errorCode = GetLastError();
+            CloseHandle(m_mapping);
+            throw std::runtime_error(GetExceptionString("Failed to map shared memory.", errorCode));
+        }
+        if (create)
+        {
+            SharedRing::Init(m_view + s_stateSize, s_ringCapacity);
+            SharedRing::Init(m_view + s_stateSize + s_ringSize, s_ringCapacity);
+            State().store(Listening, std::memory_order_release);
+        }
+        else
+        {
+            // Attaches only to a block which is set up and has no peer yet.
+            uint32_t state = Listening;
+            if (!State().compare_exchange_strong(state, Connected, std::memory_order_acq_rel))
+            {
+                UnmapViewOfFile(m_view);
+                CloseHandle(m_mapping);
+                throw std::runtime_error(state == Connected ? "Failed to connect to server: it already has a peer."
+                                                            : "Failed to connect to server: it is not listening yet.");
+            }
+        }
+
+        try
+        {
+            m_accept = CreateChannelEvent(port, "accept");
+            for (int direction = s_clientToServer; direction <= s_serverToClient; ++direction)
+            {
+                m_data[direction] = CreateChannelEvent(port, "data" + std::to_string(direction));
+                m_space[direction] = CreateChannelEvent(port, "space" + std::to_string(direction));
+            }
+        }
+        catch (...)
+        {
+            CloseEvents();
+            UnmapViewOfFile(m_view);
+            CloseHandle(m_mapping);
+            throw;
+        }
+    }
+
+    ~Channel()
+    {
+        for (int direction = s_clientToServer; direction <= s_serverToClient; ++direction)
+        {
+            Ring(direction).Close();
+            SetEvent(m_data[direction]);
+            SetEvent(m_space[direction]);
+        }
+        CloseEvents();
+        UnmapViewOfFile(m_view);
+        CloseHandle(m_mapping);
+    }
+
+    SharedRing Ring(int direction) const { return SharedRing(m_view + s_stateSize + direction * s_ringSize); }
+    HANDLE DataEvent(int direction) const { return m_data[direction]; }
+    HANDLE SpaceEvent(int direction) const { return m_space[direction]; }
+    HANDLE AcceptEvent() const { return m_accept; }
+
+private:
+    std::atomic<uint32_t>& State() const { return *reinterpret_cast<std::atomic<uint32_t>*>(m_view); }
+
+    void CloseEvents()
+    {
+        HANDLE* events[] = {&m_accept, &m_data[0], &m_data[1], &m_space[0], &m_space[1]};
+        for (HANDLE* event : events)
+        {
+            if (*event)
+            {
+                CloseHandle(*event);
+                *event = nullptr;
+            }
+        }
+    }
+
+private:
+    HANDLE m_mapping;
+    char* m_view;
+    HANDLE m_accept;
+    HANDLE m_data[2];
+    HANDLE m_space[2];
+};
+
+SharedMemorySocketWrapper::SharedMemorySocketWrapper()
+    : m_server(false)
+{
+}
+
+SharedMemorySocketWrapper::SharedMemorySocketWrapper(ChannelPtr channel, bool server)
+    : m_channel(channel)
+    , m_server(server)
+{
+}
+
+void SharedMemorySocketWrapper::Bind(const std::string&, int16_t port)
+{
+    m_channel = std::make_shared<Channel>(port, true);
+    m_server = true;
+}
+
+void SharedMemorySocketWrapper::Listen()
+{
+    if (!m_channel)
+    {
+        throw std::runtime_error("Failed to listen on socket: it is not bound.");
+    }
+}
+
+ISocketWrapperPtr SharedMemorySocketWrapper::Accept()
+{
+    if (!m_channel || !m_server)
+    {
+        throw std::runtime_error("Failed to connect to client: socket is not listening.");
+    }
+    if (WaitForSingleObject(m_channel->AcceptEvent(), INFINITE) != WAIT_OBJECT_0)
+    {
+        throw std::runtime_error(GetExceptionString("Failed to connect to client.", GetLastError()));
+    }
+    return ISocketWrapperPtr(new SharedMemorySocketWrapper(m_channel, true));
+}
+
+ISocketWrapperPtr SharedMemorySocketWrapper::Connect(const std::string&, int16_t port)
+{
+    m_channel = std::make_shared<Channel>(port, false);
+    m_server = false;
+    SetEvent(m_channel->AcceptEvent());
+    return ISocketWrapperPtr(new SharedMemorySocketWrapper(m_channel, false));
+}
+
+void SharedMemorySocketWrapper::Read(std::string& buffer)
+{
+    buffer.resize(1024); // 1KB
+    buffer.resize(Read(&buffer[0], buffer.size()));
+}
+
+size_t SharedMemorySocketWrapper::Read(char* buffer, size_t size)
+{
+    if (!m_channel)
+    {
+        throw std::runtime_error("Failed to read data: socket is not connected.");
+    }
+
+    const int direction = m_server ? s_clientToServer : s_serverToClient;
+    SharedRing ring = m_channel->Ring(direction);
+    for (;;)
+    {
+        // Checked before reading, so everything written before Close is still delivered.
+        const bool closed = ring.IsClosed();
+        size_t portion = ring.Read(buffer, size);
+        if (portion)
+        {
+            SetEvent(m_channel->SpaceEvent(direction));
+            return portion;
+        }
+        if (closed)
+        {
+            return 0;
+        }
+        WaitForSingleObject(m_channel->DataEvent(direction), INFINITE);
+    }
+}
+
+void SharedMemorySocketWrapper::Write(const std::string& buffer)
+{
+    if (!m_channel)
+    {
+        throw std::runtime_error("Failed to send data: socket is not connected.");
+    }
+
+    const int direction = m_server ? s_serverToClient : s_clientToServer;
+    SharedRing ring = m_channel->Ring(direction);
+    for (size_t dataSent = 0; dataSent < buffer.size();)
+    {
+        if (ring.IsClosed())
+        {
+            throw std::runtime_error("Failed to send data: connection is closed.");
+        }
+        size_t portion = ring.Write(buffer.data() + dataSent, buffer.size() - dataSent);
+        if (portion)
+        {
+            dataSent += portion;
+            SetEvent(m_channel->DataEvent(direction));
+        }
+        else
+        {
+            WaitForSingleObject(m_channel->SpaceEvent(direction), INFINITE);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "isocketwrapper.h"
+
+/*
+ *  Transport for peers on the same host over a named shared-memory block.
+ *
+ * The block holds two SharedRing objects, one per direction. Sides wake each other up
+ * with named auto-reset events, so nobody spins and no data goes through the network stack.
+ * The port number names the block: Bind fails if it already exists, Connect fails if it doesn't,
+ * which keeps the Bind/Listen/Accept/Connect semantics of SocketWrapper.
+ * Only one connection per bound port is supported: Connect fails once a peer has attached,
+ * and also while the server is still setting the block up.
+*/
+
+class SharedMemorySocketWrapper : public ISocketWrapper
+{
+public:
+    SharedMemorySocketWrapper();
+
+    void Bind(const std::string& addr, int16_t port) override;
+    void Listen() override;
+    ISocketWrapperPtr Accept() override;
+    ISocketWrapperPtr Connect(const std::string& addr, int16_t port) override;
+    void Read(std::string& buffer) override;
+    // Returns 0 when the other side has closed the connection and all its data is read.
+    size_t Read(char* buffer, size_t size) override;
+    void Write(const std::string& buffer) override;
+
+private:
+    class Channel;
+    using ChannelPtr = std::shared_ptr<Channel>;
+
+    SharedMemorySocketWrapper(ChannelPtr channel, bool server);
+
+private:
+    ChannelPtr m_channel;
+    bool m_server;
+};
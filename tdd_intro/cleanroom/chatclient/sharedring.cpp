@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "sharedring.h"
+
+size_t SharedRing::RequiredSize(uint32_t capacity)
+{
+    return sizeof(Header) + capacity;
+}
+
+void SharedRing::Init(void* memory, uint32_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        throw std::invalid_argument("Ring capacity must be a power of two.");
+    }
+
+    Header* header = new (memory) Header;
+    header->head.store(0);
+    header->tail.store(0);
+    header->closed.store(0);
+    header->capacity = capacity;
+}
+
+SharedRing::SharedRing(void* memory)
+    : m_header(static_cast<Header*>(memory))
+    , m_data(static_cast<char*>(memory) + sizeof(Header))
+{
+}
+
+size_t SharedRing::Write(const char* data, size_t size)
+{
+    const uint32_t head = m_header->head.load(std::memory_order_relaxed);
+    const uint32_t tail = m_header->tail.load(std::memory_order_acquire);
+    const uint32_t capacity = m_header->capacity;
+    const size_t portion = std::min<size_t>(size, capacity - (head - tail));
+
+    const uint32_t start = head & (capacity - 1);
+    const size_t firstPart = std::min<size_t>(portion, capacity - start);
+    std::memcpy(m_data + start, data, firstPart);
+    std::memcpy(m_data, data + firstPart, portion - firstPart);
+
+    m_header->head.store(head + static_cast<uint32_t>(portion), std::memory_order_release);
+    return portion;
+}
+
+size_t SharedRing::Read(char* data, size_t size)
+{
+    const uint32_t tail = m_header->tail.load(std::memory_order_relaxed);
+    const uint32_t head = m_header->head.load(std::memory_order_acquire);
+    const uint32_t capacity = m_header->capacity;
+    const size_t portion = std::min<size_t>(size, head - tail);
+
+    const uint32_t start = tail & (capacity - 1);
+    const size_t firstPart = std::min<size_t>(portion, capacity - start);
+    std::memcpy(data, m_data + start, firstPart);
+    std::memcpy(data + firstPart, m_data, portion - firstPart);
+
+    m_header->tail.store(tail + static_cast<uint32_t>(portion), std::memory_order_release);
+    return portion;
+}
+
+void SharedRing::Close()
+{
+    m_header->closed.store(1, std::memory_order_release);
+}
+
+bool SharedRing::IsClosed() const
+{
+    return m_header->closed.load(std::memory_order_acquire) != 0;
+}
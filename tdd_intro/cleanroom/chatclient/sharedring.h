@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ *  Single producer, single consumer byte ring placed into caller-provided memory.
+ *
+ * The memory may be shared between processes: the ring keeps no pointers, only
+ * free-running head and tail counters next to the data. Neither side ever blocks,
+ * waiting for data or space is up to the transport built on top of the ring.
+*/
+
+class SharedRing
+{
+public:
+    // Memory size needed for the ring of given capacity.
+    static size_t RequiredSize(uint32_t capacity);
+    // Creates an empty ring in memory. Capacity must be a power of two, otherwise std::invalid_argument is thrown.
+    static void Init(void* memory, uint32_t capacity);
+
+    // Attaches to the ring created by Init, possibly in another process.
+    explicit SharedRing(void* memory);
+
+    // Copies as much of data as fits and returns the number of bytes written.
+    size_t Write(const char* data, size_t size);
+    // Copies at most size bytes of available data and returns the number of bytes read.
+    size_t Read(char* data, size_t size);
+
+    // Marks the ring as closed by either side. Data already written can still be read.
+    void Close();
+    bool IsClosed() const;
+
+private:
+    struct Header
+    {
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+        std::atomic<uint32_t> closed;
+        uint32_t capacity;
+    };
+
+    Header* m_header;
+    char* m_data;
+};
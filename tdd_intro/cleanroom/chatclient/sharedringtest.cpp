@@ -0,0 +1,97 @@
+// Tests for the byte ring used by the shared-memory transport.
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "sharedring.h"
+
+TEST(SharedRingTest, ReadsWhatWasWritten)
+{
+    std::vector<char> memory(SharedRing::RequiredSize(16));
+    SharedRing::Init(memory.data(), 16);
+    SharedRing ring(memory.data());
+
+    EXPECT_EQ(5, ring.Write("Hello", 5));
+    char buffer[16] = {};
+    EXPECT_EQ(5, ring.Read(buffer, sizeof(buffer)));
+    EXPECT_EQ("Hello", std::string(buffer, 5));
+    EXPECT_EQ(0, ring.Read(buffer, sizeof(buffer)));
+}
+
+TEST(SharedRingTest, WritesOnlyWhatFits)
+{
+    std::vector<char> memory(SharedRing::RequiredSize(8));
+    SharedRing::Init(memory.data(), 8);
+    SharedRing ring(memory.data());
+
+    EXPECT_EQ(8, ring.Write("0123456789", 10));
+    EXPECT_EQ(0, ring.Write("a", 1));
+
+    char buffer[4];
+    EXPECT_EQ(4, ring.Read(buffer, sizeof(buffer)));
+    // Wraps around the end of the data area.
+    EXPECT_EQ(3, ring.Write("abc", 3));
+
+    char rest[8];
+    EXPECT_EQ(7, ring.Read(rest, sizeof(rest)));
+    EXPECT_EQ("4567abc", std::string(rest, 7));
+}
+
+TEST(SharedRingTest, RejectsCapacityNotPowerOfTwo)
+{
+    std::vector<char> memory(SharedRing::RequiredSize(12));
+    EXPECT_THROW(SharedRing::Init(memory.data(), 12), std::invalid_argument);
+}
+
+TEST(SharedRingTest, CloseIsVisibleToOtherSide)
+{
+    std::vector<char> memory(SharedRing::RequiredSize(8));
+    SharedRing::Init(memory.data(), 8);
+    SharedRing writer(memory.data());
+    SharedRing reader(memory.data());
+
+    EXPECT_FALSE(reader.IsClosed());
+    writer.Close();
+    EXPECT_TRUE(reader.IsClosed());
+}
+
+TEST(SharedRingTest, TransfersStreamBetweenThreads)
+{
+    std::vector<char> memory(SharedRing::RequiredSize(64));
+    SharedRing::Init(memory.data(), 64);
+
+    std::string sent;
+    for (int i = 0; i < 10000; ++i)
+    {
+        sent += std::to_string(i);
+    }
+
+    std::thread producer([&]()
+    {
+        SharedRing ring(memory.data());
+        for (size_t written = 0; written < sent.size();)
+        {
+            size_t portion = ring.Write(sent.data() + written, sent.size() - written);
+            written += portion;
+            if (!portion)
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    SharedRing ring(memory.data());
+    std::string received;
+    char buffer[32];
+    while (received.size() < sent.size())
+    {
+        size_t portion = ring.Read(buffer, sizeof(buffer));
+        received.append(buffer, portion);
+        if (!portion)
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    EXPECT_EQ(sent, received);
+}
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+#include "socketrecorder.h"
+
+namespace
+{
+    const char s_magic[] = "CHATCAP";
+    const char s_version = 2;
+
+    void WriteVarint(std::ostream& stream, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            stream.put(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        stream.put(static_cast<char>(value));
+    }
+
+    bool ReadVarint(std::istream& stream, uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            int byte = stream.get();
+            if (byte == std::char_traits<char>::eof())
+            {
+                return false;
+            }
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        throw std::runtime_error("Malformed capture record.");
+    }
+}
+
+CaptureWriter::CaptureWriter(std::ostream& stream)
+    : m_stream(stream)
+    , m_connectionCount(0)
+    , m_start(std::chrono::steady_clock::now())
+    , m_lastOffset(0)
+{
+    m_stream.write(s_magic, sizeof(s_magic));
+    m_stream.put(s_version);
+}
+
+uint32_t CaptureWriter::NewConnection()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_connectionCount++;
+}
+
+void CaptureWriter::Append(uint32_t connection, CaptureDirection direction, const char* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto offset = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+    m_stream.put(static_cast<char>(direction));
+    WriteVarint(m_stream, connection);
+    WriteVarint(m_stream, static_cast<uint64_t>((offset - m_lastOffset).count()));
+    WriteVarint(m_stream, size);
+    m_stream.write(data, static_cast<std::streamsize>(size));
+    m_lastOffset = offset;
+}
+
+CaptureReader::CaptureReader(std::istream& stream)
+    : m_stream(stream)
+    , m_lastOffset(0)
+    , m_connectionCount(0)
+{
+    char header[sizeof(s_magic) + 1] = {};
+    m_stream.read(header, sizeof(header));
+    if (!m_stream || std::string(header, sizeof(s_magic)) != std::string(s_magic, sizeof(s_magic)) ||
+        header[sizeof(s_magic)] != s_version)
+    {
+        throw std::runtime_error("Stream is not a chat capture.");
+    }
+}
+
+uint32_t CaptureReader::NewConnection()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_connectionCount++;
+}
+
+bool CaptureReader::Next(CaptureRecord& record)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return ReadRecord(record);
+}
+
+bool CaptureReader::Next(uint32_t connection, CaptureRecord& record)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto ahead = m_readAhead.find(connection);
+    if (ahead != m_readAhead.end())
+    {
+        record = std::move(ahead->second.front());
+        ahead->second.pop_front();
+        if (ahead->second.empty())
+        {
+            m_readAhead.erase(ahead);
+        }
+        return true;
+    }
+
+    while (ReadRecord(record))
+    {
+        if (record.connection == connection)
+        {
+            return true;
+        }
+        m_readAhead[record.connection].push_back(std::move(record));
+    }
+    return false;
+}
+
+bool CaptureReader::ReadRecord(CaptureRecord& record)
+{
+    int direction = m_stream.get();
+    if (direction == std::char_traits<char>::eof())
+    {
+        return false;
+    }
+    if (direction != static_cast<char>(CaptureDirection::Read) && direction != static_cast<char>(CaptureDirection::Write))
+    {
+        throw std::runtime_error("Malformed capture record.");
+    }
+
+    uint64_t connection = 0;
+    uint64_t delta = 0;
+    uint64_t size = 0;
+    if (!ReadVarint(m_stream, connection) || !ReadVarint(m_stream, delta) || !ReadVarint(m_stream, size))
+    {
+        throw std::runtime_error("Truncated capture record.");
+    }
+
+    record.direction = static_cast<CaptureDirection>(direction);
+    record.connection = static_cast<uint32_t>(connection);
+    m_lastOffset += std::chrono::microseconds(delta);
+    record.offset = m_lastOffset;
+    record.data.resize(static_cast<size_t>(size));
+    if (size && !m_stream.read(&record.data[0], static_cast<std::streamsize>(size)))
+    {
+        throw std::runtime_error("Truncated capture record.");
+    }
+    return true;
+}
+
+RecordingSocketWrapper::RecordingSocketWrapper(ISocketWrapperPtr socket, CaptureWriterPtr capture)
+    : m_socket(socket)
+    , m_capture(capture)
+    , m_connection(capture->NewConnection())
+{
+}
+
+void RecordingSocketWrapper::Bind(const std::string& addr, int16_t port)
+{
+    m_socket->Bind(addr, port);
+}
+
+void RecordingSocketWrapper::Listen()
+{
+    m_socket->Listen();
+}
+
+ISocketWrapperPtr RecordingSocketWrapper::Accept()
+{
+    return std::make_shared<RecordingSocketWrapper>(m_socket->Accept(), m_capture);
+}
+
+ISocketWrapperPtr RecordingSocketWrapper::Connect(const std::string& addr, int16_t port)
+{
+    return std::make_shared<RecordingSocketWrapper>(m_socket->Connect(addr, port), m_capture);
+}
+
+void RecordingSocketWrapper::Read(std::string& buffer)
+{
+    m_socket->Read(buffer);
+    m_capture->Append(m_connection, CaptureDirection::Read, buffer.data(), buffer.size());
+}
+
+size_t RecordingSocketWrapper::Read(char* buffer, size_t size)
+{
+    size_t received = m_socket->Read(buffer, size);
+    m_capture->Append(m_connection, CaptureDirection::Read, buffer, received);
+    return received;
+}
+
+void RecordingSocketWrapper::Write(const std::string& buffer)
+{
+    m_socket->Write(buffer);
+    m_capture->Append(m_connection, CaptureDirection::Write, buffer.data(), buffer.size());
+}
+
+ReplaySocketWrapper::ReplaySocketWrapper(CaptureReaderPtr capture, Pace pace)
+    : m_capture(capture)
+    , m_connection(capture->NewConnection())
+    , m_pace(pace)
+    , m_start(std::chrono::steady_clock::now())
+{
+}
+
+void ReplaySocketWrapper::Bind(const std::string&, int16_t)
+{
+}
+
+void ReplaySocketWrapper::Listen()
+{
+}
+
+ISocketWrapperPtr ReplaySocketWrapper::Accept()
+{
+    auto connection = std::make_shared<ReplaySocketWrapper>(m_capture, m_pace);
+    connection->m_start = m_start;
+    return connection;
+}
+
+ISocketWrapperPtr ReplaySocketWrapper::Connect(const std::string&, int16_t)
+{
+    auto connection = std::make_shared<ReplaySocketWrapper>(m_capture, m_pace);
+    connection->m_start = m_start;
+    return connection;
+}
+
+void ReplaySocketWrapper::Read(std::string& buffer)
+{
+    FetchPending();
+    buffer.swap(m_pending);
+    m_pending.clear();
+}
+
+size_t ReplaySocketWrapper::Read(char* buffer, size_t size)
+{
+    FetchPending();
+    size_t portion = std::min(size, m_pending.size());
+    std::copy(m_pending.begin(), m_pending.begin() + portion, buffer);
+    m_pending.erase(0, portion);
+    return portion;
+}
+
+void ReplaySocketWrapper::Write(const std::string&)
+{
+}
+
+void ReplaySocketWrapper::FetchPending()
+{
+    if (!m_pending.empty())
+    {
+        return;
+    }
+
+    CaptureRecord record;
+    do
+    {
+        if (!m_capture->Next(m_connection, record))
+        {
+            throw std::runtime_error("Capture is over.");
+        }
+    }
+    while (record.direction != CaptureDirection::Read);
+
+    if (m_pace == Pace::Original)
+    {
+        std::this_thread::sleep_until(m_start + record.offset);
+    }
+    m_pending.swap(record.data);
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include "isocketwrapper.h"
+
+/*
+ *  Traffic record/replay for ISocketWrapper.
+ *
+ * RecordingSocketWrapper decorates a real socket and appends every Read and Write to a capture.
+ * ReplaySocketWrapper plays a capture back: its Read returns the recorded incoming data,
+ * either as fast as possible or at the original pace, and its Write discards the data.
+ * This way traffic captured under real load can be fed to the chat logic as a repeatable benchmark.
+ *
+ * Every wrapper is a connection of its own: the one created by the caller and each one returned
+ * by Accept or Connect. Connections get ids in the order they were created and may record from
+ * different threads into one capture. On replay connections are created in the same order,
+ * so each of them reads back the traffic of the recorded connection with the same id.
+ *
+ * Capture format: "CHATCAP" magic and a version byte, followed by records of
+ *   <direction:1 byte> <connection:varint> <microseconds since previous record:varint> <size:varint> <data>
+*/
+
+enum class CaptureDirection : char
+{
+    Read = 'R',
+    Write = 'W'
+};
+
+struct CaptureRecord
+{
+    CaptureDirection direction;
+    uint32_t connection;
+    // Time since the capture was started.
+    std::chrono::microseconds offset;
+    std::string data;
+};
+
+class CaptureWriter
+{
+public:
+    explicit CaptureWriter(std::ostream& stream);
+
+    // Returns the id of the next connection, from 0.
+    uint32_t NewConnection();
+    // May be called from several threads, records are never interleaved.
+    void Append(uint32_t connection, CaptureDirection direction, const char* data, size_t size);
+
+private:
+    std::mutex m_mutex;
+    std::ostream& m_stream;
+    uint32_t m_connectionCount;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::microseconds m_lastOffset;
+};
+
+class CaptureReader
+{
+public:
+    // Throws if the stream does not start with a capture header.
+    explicit CaptureReader(std::istream& stream);
+
+    // Returns the id of the next replayed connection, from 0.
+    uint32_t NewConnection();
+    // Returns records of all connections in capture order, false when the capture is over.
+    // Throws if a record is malformed.
+    bool Next(CaptureRecord& record);
+    // Returns the next record of the connection. Records of other connections met on the way
+    // are kept for them. Don't mix with the Next above on the same reader.
+    bool Next(uint32_t connection, CaptureRecord& record);
+
+private:
+    bool ReadRecord(CaptureRecord& record);
+
+private:
+    std::mutex m_mutex;
+    std::istream& m_stream;
+    std::chrono::microseconds m_lastOffset;
+    uint32_t m_connectionCount;
+    std::map<uint32_t, std::deque<CaptureRecord>> m_readAhead;
+};
+
+using CaptureWriterPtr = std::shared_ptr<CaptureWriter>;
+using CaptureReaderPtr = std::shared_ptr<CaptureReader>;
+
+class RecordingSocketWrapper : public ISocketWrapper
+{
+public:
+    RecordingSocketWrapper(ISocketWrapperPtr socket, CaptureWriterPtr capture);
+
+    void Bind(const std::string& addr, int16_t port) override;
+    void Listen() override;
+    // Returned connections are recorded into the same capture under their own ids.
+    ISocketWrapperPtr Accept() override;
+    ISocketWrapperPtr Connect(const std::string& addr, int16_t port) override;
+    void Read(std::string& buffer) override;
+    size_t Read(char* buffer, size_t size) override;
+    void Write(const std::string& buffer) override;
+
+private:
+    ISocketWrapperPtr m_socket;
+    CaptureWriterPtr m_capture;
+    uint32_t m_connection;
+};
+
+class ReplaySocketWrapper : public ISocketWrapper
+{
+public:
+    enum class Pace
+    {
+        AsFastAsPossible,
+        Original
+    };
+
+    ReplaySocketWrapper(CaptureReaderPtr capture, Pace pace);
+
+    void Bind(const std::string& addr, int16_t port) override;
+    void Listen() override;
+    // Returned connections replay the traffic of the next recorded connection.
+    ISocketWrapperPtr Accept() override;
+    ISocketWrapperPtr Connect(const std::string& addr, int16_t port) override;
+    // Returns the next recorded incoming data. Throws when the capture is over,
+    // the same way the real socket does when the connection is dropped.
+    void Read(std::string& buffer) override;
+    // Returns at most size bytes of recorded incoming data, the rest is returned by the next Read.
+    size_t Read(char* buffer, size_t size) override;
+    void Write(const std::string& buffer) override;
+
+private:
+    void FetchPending();
+
+private:
+    CaptureReaderPtr m_capture;
+    uint32_t m_connection;
+    Pace m_pace;
+    std::chrono::steady_clock::time_point m_start;
+    std::string m_pending;
+};
@@ -0,0 +1,165 @@
+// Tests for capture recording and replay of socket traffic.
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include "mocks.h"
+#include "socketrecorder.h"
+
+using namespace testing;
+
+TEST(SocketRecorderTest, ReplayReturnsRecordedReads)
+{
+    auto socket = std::make_shared<SocketWrapperMock>();
+    EXPECT_CALL(*socket, Read(_))
+        .WillOnce(SetArgReferee<0>(std::string("user:HELLO!")))
+        .WillOnce(SetArgReferee<0>(std::string("Hello!\0", 7)));
+    EXPECT_CALL(*socket, Write("metizik:HELLO!"));
+
+    std::stringstream stream;
+    RecordingSocketWrapper recorder(socket, std::make_shared<CaptureWriter>(stream));
+    std::string buffer;
+    recorder.Write("metizik:HELLO!");
+    recorder.Read(buffer);
+    recorder.Read(buffer);
+
+    ReplaySocketWrapper replay(std::make_shared<CaptureReader>(stream), ReplaySocketWrapper::Pace::AsFastAsPossible);
+    replay.Write("metizik:HELLO!");
+    replay.Read(buffer);
+    EXPECT_EQ("user:HELLO!", buffer);
+    replay.Read(buffer);
+    EXPECT_EQ(std::string("Hello!\0", 7), buffer);
+    EXPECT_THROW(replay.Read(buffer), std::runtime_error);
+}
+
+TEST(SocketRecorderTest, CaptureKeepsDirectionAndOrder)
+{
+    std::stringstream stream;
+    CaptureWriter writer(stream);
+    writer.Append(0, CaptureDirection::Write, "a", 1);
+    writer.Append(0, CaptureDirection::Read, "bc", 2);
+
+    CaptureReader reader(stream);
+    CaptureRecord record;
+    ASSERT_TRUE(reader.Next(record));
+    EXPECT_EQ(CaptureDirection::Write, record.direction);
+    EXPECT_EQ("a", record.data);
+    std::chrono::microseconds firstOffset = record.offset;
+
+    ASSERT_TRUE(reader.Next(record));
+    EXPECT_EQ(CaptureDirection::Read, record.direction);
+    EXPECT_EQ("bc", record.data);
+    EXPECT_GE(record.offset, firstOffset);
+
+    EXPECT_FALSE(reader.Next(record));
+}
+
+TEST(SocketRecorderTest, RejectsForeignStream)
+{
+    std::stringstream stream("not a capture");
+    EXPECT_THROW(CaptureReader reader(stream), std::runtime_error);
+}
+
+TEST(SocketRecorderTest, ReplayFillsCallerBufferInPortions)
+{
+    std::stringstream stream;
+    CaptureWriter writer(stream);
+    writer.Append(0, CaptureDirection::Read, "Hello!", 6);
+
+    ReplaySocketWrapper replay(std::make_shared<CaptureReader>(stream), ReplaySocketWrapper::Pace::AsFastAsPossible);
+    char buffer[4] = {};
+    ASSERT_EQ(4, replay.Read(buffer, sizeof(buffer)));
+    EXPECT_EQ("Hell", std::string(buffer, 4));
+    ASSERT_EQ(2, replay.Read(buffer, sizeof(buffer)));
+    EXPECT_EQ("o!", std::string(buffer, 2));
+}
+
+TEST(SocketRecorderTest, RecordsReadIntoCallerBuffer)
+{
+    auto socket = std::make_shared<SocketWrapperMock>();
+    EXPECT_CALL(*socket, Read(_, 16)).WillOnce(DoAll(SetArrayArgument<0>("abc", "abc" + 3), Return(3)));
+
+    std::stringstream stream;
+    RecordingSocketWrapper recorder(socket, std::make_shared<CaptureWriter>(stream));
+    char buffer[16];
+    EXPECT_EQ(3, recorder.Read(buffer, sizeof(buffer)));
+
+    CaptureReader reader(stream);
+    CaptureRecord record;
+    ASSERT_TRUE(reader.Next(record));
+    EXPECT_EQ("abc", record.data);
+}
+
+TEST(SocketRecorderTest, ReplaysAcceptedConnectionsSeparately)
+{
+    auto listener = std::make_shared<SocketWrapperMock>();
+    auto first = std::make_shared<SocketWrapperMock>();
+    auto second = std::make_shared<SocketWrapperMock>();
+    EXPECT_CALL(*listener, Accept()).WillOnce(Return(first)).WillOnce(Return(second));
+    EXPECT_CALL(*first, Read(_)).WillOnce(SetArgReferee<0>(std::string("first:HELLO!")));
+    EXPECT_CALL(*second, Read(_)).WillOnce(SetArgReferee<0>(std::string("second:HELLO!")));
+
+    std::stringstream stream;
+    RecordingSocketWrapper recorder(listener, std::make_shared<CaptureWriter>(stream));
+    ISocketWrapperPtr firstRecorder = recorder.Accept();
+    ISocketWrapperPtr secondRecorder = recorder.Accept();
+    std::string buffer;
+    secondRecorder->Read(buffer);
+    firstRecorder->Read(buffer);
+
+    ReplaySocketWrapper replay(std::make_shared<CaptureReader>(stream), ReplaySocketWrapper::Pace::AsFastAsPossible);
+    ISocketWrapperPtr firstReplay = replay.Accept();
+    ISocketWrapperPtr secondReplay = replay.Accept();
+    firstReplay->Read(buffer);
+    EXPECT_EQ("first:HELLO!", buffer);
+    secondReplay->Read(buffer);
+    EXPECT_EQ("second:HELLO!", buffer);
+    EXPECT_THROW(firstReplay->Read(buffer), std::runtime_error);
+}
+
+TEST(SocketRecorderTest, ConcurrentAppendsKeepRecordsWhole)
+{
+    std::stringstream stream;
+    CaptureWriter writer(stream);
+    const std::string data(1000, 'x');
+    std::vector<std::thread> threads;
+    for (uint32_t connection = 0; connection < 4; ++connection)
+    {
+        threads.emplace_back([&writer, &data, connection]()
+        {
+            for (int i = 0; i < 100; ++i)
+            {
+                writer.Append(connection, CaptureDirection::Write, data.data(), data.size());
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    CaptureReader reader(stream);
+    CaptureRecord record;
+    size_t records[4] = {};
+    while (reader.Next(record))
+    {
+        ASSERT_LT(record.connection, 4u);
+        EXPECT_EQ(data, record.data);
+        ++records[record.connection];
+    }
+    EXPECT_THAT(records, Each(100));
+}
+
+TEST(SocketRecorderTest, RejectsUnknownDirection)
+{
+    std::stringstream stream;
+    {
+        CaptureWriter writer(stream);
+    }
+    // Record of connection 0 with a well formed body but no such direction.
+    const std::string record("X\0\0\1a", 5);
+    stream.write(record.data(), record.size());
+
+    CaptureReader reader(stream);
+    CaptureRecord next;
+    EXPECT_THROW(reader.Next(next), std::runtime_error);
+}
@@ -3,11 +3,14 @@
 
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <afunix.h>
+#include <climits>
 #include <exception>
-#include <vector>
 #include <sstream>
 
 #include "SocketWrapper.h"
+#include "sessionpool.h"
+#include "sharedmemorysocketwrapper.h"
 
 namespace
 {
@@ -48,14 +51,99 @@ namespace
     };
 
     std::unique_ptr<WsaSubsystem> WsaSubsystem::m_self;
+
+    std::string LocalSocketPath(int16_t port)
+    {
+        char tempPath[MAX_PATH + 1] = {};
+        GetTempPathA(sizeof(tempPath), tempPath);
+        return std::string(tempPath) + "chatclient-" + std::to_string(port) + ".sock";
+    }
+
+    // Closes the socket unless it is released to its owner.
+    class SocketGuard
+    {
+    public:
+        explicit SocketGuard(SOCKET socket)
+            : m_socket(socket)
+        {
+        }
+
+        ~SocketGuard()
+        {
+            if (m_socket != INVALID_SOCKET)
+            {
+                closesocket(m_socket);
+            }
+        }
+
+        SOCKET Get() const { return m_socket; }
+        void Release() { m_socket = INVALID_SOCKET; }
+
+    private:
+        SocketGuard(const SocketGuard&);
+        SocketGuard& operator=(const SocketGuard&);
+
+        SOCKET m_socket;
+    };
+
+    // Puts the socket back to blocking mode when leaving the scope.
+    class BlockingModeRestorer
+    {
+    public:
+        explicit BlockingModeRestorer(SOCKET socket)
+            : m_socket(socket)
+        {
+        }
+
+        ~BlockingModeRestorer()
+        {
+            u_long blocking = 0;
+            ioctlsocket(m_socket, FIONBIO, &blocking); // There is nothing to do with returned value in destructor
+        }
+
+    private:
+        BlockingModeRestorer(const BlockingModeRestorer&);
+        BlockingModeRestorer& operator=(const BlockingModeRestorer&);
+
+        SOCKET m_socket;
+    };
+
+    sockaddr_un LocalSocketAddress(const std::string& path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error("Socket path is too long: " + path);
+        }
+        path.copy(address.sun_path, path.size());
+        return address;
+    }
 }
 
 SocketWrapper::SocketWrapper()
+    : SocketWrapper(AF_INET)
+{
+}
+
+// Zero-copy send in flight. Its payload and overlapped structure must stay in place until the send completes.
+struct SocketWrapper::PendingSend
+{
+    WSAOVERLAPPED overlapped;
+    std::string payload;
+    ZeroCopyCompletion completion;
+    bool done;
+};
+
+SocketWrapper::SocketWrapper(int addressFamily)
     : m_socket(INVALID_SOCKET)
+    , m_zeroCopyThreshold(0)
+    , m_sendBufferSize(0)
+    , m_nextSendId(0)
 {
     WsaSubsystem::Init();
 
-    m_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    m_socket = socket(addressFamily, SOCK_STREAM, addressFamily == AF_INET ? IPPROTO_TCP : 0);
     if (m_socket == INVALID_SOCKET)
     {
         throw std::runtime_error(GetExceptionString("Failed to create socket to listen on.", WSAGetLastError()));
@@ -64,13 +152,25 @@ SocketWrapper::SocketWrapper()
 
 SocketWrapper::SocketWrapper(SOCKET & other)
     : m_socket(other)
+    , m_zeroCopyThreshold(0)
+    , m_sendBufferSize(0)
+    , m_nextSendId(0)
 {
     WsaSubsystem::Init();
 }
 
 SocketWrapper::~SocketWrapper()
 {
+    // Closing the socket aborts sends in flight, their payloads may be freed once they complete.
     closesocket(m_socket);
+    for (const auto& send : m_pendingSends)
+    {
+        if (!send->done)
+        {
+            WaitForSingleObject(send->overlapped.hEvent, INFINITE);
+            WSACloseEvent(send->overlapped.hEvent);
+        }
+    }
 }
 
 void SocketWrapper::Bind(const std::string& addr, int16_t port)
@@ -100,7 +200,51 @@ ISocketWrapperPtr SocketWrapper::Accept()
     {
         throw std::runtime_error(GetExceptionString("Failed to connect to client.", WSAGetLastError()));
     }
-    return ISocketWrapperPtr(new SocketWrapper(other));
+    return std::allocate_shared<SocketWrapper>(PoolAllocator<SocketWrapper>(SessionPool::Default()), other);
+}
+
+std::vector<ISocketWrapperPtr> SocketWrapper::AcceptMany(size_t maxCount)
+{
+    std::vector<ISocketWrapperPtr> accepted;
+
+    SetNonBlocking(true);
+    BlockingModeRestorer restorer(m_socket);
+    while (accepted.size() < maxCount)
+    {
+        SocketGuard other(accept(m_socket, nullptr, nullptr));
+        // Accepted sockets inherit non-blocking mode from the listener, but Read and Write are blocking.
+        u_long blocking = 0;
+        int errorCode = 0;
+        if (other.Get() == INVALID_SOCKET || ioctlsocket(other.Get(), FIONBIO, &blocking) == SOCKET_ERROR)
+        {
+            errorCode = WSAGetLastError();
+        }
+
+        if (errorCode == WSAECONNRESET)
+        {
+            // The client gave up before it was accepted, the others are still pending.
+            continue;
+        }
+        if (errorCode == WSAEWOULDBLOCK)
+        {
+            break;
+        }
+        if (errorCode != 0)
+        {
+            if (!accepted.empty())
+            {
+                // Connections accepted so far are returned rather than dropped.
+                break;
+            }
+            throw std::runtime_error(GetExceptionString("Failed to connect to client.", errorCode));
+        }
+
+        SetHandleInformation(reinterpret_cast<HANDLE>(other.Get()), HANDLE_FLAG_INHERIT, 0);
+        SOCKET handle = other.Get();
+        accepted.push_back(std::allocate_shared<SocketWrapper>(PoolAllocator<SocketWrapper>(SessionPool::Default()), handle));
+        other.Release();
+    }
+    return accepted;
 }
 
 ISocketWrapperPtr SocketWrapper::Connect(const std::string& addr, int16_t port)
@@ -114,18 +258,25 @@ ISocketWrapperPtr SocketWrapper::Connect(const std::string& addr, int16_t port)
     {
         throw std::runtime_error(GetExceptionString("Failed to connect to server.", WSAGetLastError()));
     }
-    return ISocketWrapperPtr(new SocketWrapper(other));
+    return std::allocate_shared<SocketWrapper>(PoolAllocator<SocketWrapper>(SessionPool::Default()), other);
 }
 
 void SocketWrapper::Read(std::string& buffer)
 {
-    std::vector<char> bufferTmp(1024); // 1KB
-    int portionReceived = recv(m_socket, bufferTmp.data(), static_cast<int>(bufferTmp.size()), 0);
+    buffer.resize(1024); // 1KB
+    buffer.resize(Read(&buffer[0], buffer.size()));
+}
+
+size_t SocketWrapper::Read(char* buffer, size_t size)
+{
+    // recv takes an int length: a larger buffer is filled by the following calls.
+    const int portionSize = size > INT_MAX ? INT_MAX : static_cast<int>(size);
+    int portionReceived = recv(m_socket, buffer, portionSize, 0);
     if (SOCKET_ERROR == portionReceived)
     {
         throw std::runtime_error(GetExceptionString("Failed to read data.", WSAGetLastError()));
     }
-    buffer.assign(bufferTmp.begin(), bufferTmp.begin() + portionReceived);
+    return static_cast<size_t>(portionReceived);
 }
 
 void SocketWrapper::Write(const std::string& buffer)
@@ -139,3 +290,198 @@ void SocketWrapper::Write(const std::string& buffer)
         }
     }
 }
+
+void SocketWrapper::SetNonBlocking(bool nonBlocking)
+{
+    u_long mode = nonBlocking ? 1 : 0;
+    if (ioctlsocket(m_socket, FIONBIO, &mode) == SOCKET_ERROR)
+    {
+        throw std::runtime_error(GetExceptionString("Failed to change socket blocking mode.", WSAGetLastError()));
+    }
+}
+
+void SocketWrapper::SetZeroCopyThreshold(size_t minSize)
+{
+    std::lock_guard<std::mutex> lock(m_zeroCopyMutex);
+    if (minSize && !m_zeroCopyThreshold)
+    {
+        // With no send buffer Winsock transmits straight from the user memory and completes
+        // the overlapped send only when it doesn't need the data anymore.
+        int optionSize = sizeof(m_sendBufferSize);
+        if (getsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<char*>(&m_sendBufferSize), &optionSize) == SOCKET_ERROR)
+        {
+            throw std::runtime_error(GetExceptionString("Failed to get send buffer size.", WSAGetLastError()));
+        }
+        int noBuffer = 0;
+        if (setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&noBuffer), sizeof(noBuffer)) == SOCKET_ERROR)
+        {
+            throw std::runtime_error(GetExceptionString("Failed to turn off send buffer.", WSAGetLastError()));
+        }
+    }
+    else if (!minSize && m_zeroCopyThreshold)
+    {
+        if (setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&m_sendBufferSize), sizeof(m_sendBufferSize)) == SOCKET_ERROR)
+        {
+            throw std::runtime_error(GetExceptionString("Failed to restore send buffer.", WSAGetLastError()));
+        }
+    }
+    m_zeroCopyThreshold = minSize;
+}
+
+uint64_t SocketWrapper::WriteZeroCopy(std::string payload)
+{
+    std::unique_ptr<PendingSend> send(new PendingSend());
+    send->payload.swap(payload);
+    send->done = false;
+
+    std::lock_guard<std::mutex> lock(m_zeroCopyMutex);
+    send->completion.id = m_nextSendId;
+    if (!m_zeroCopyThreshold || send->payload.size() < m_zeroCopyThreshold)
+    {
+        Write(send->payload);
+        send->completion.bytesSent = send->payload.size();
+        send->completion.errorCode = 0;
+        send->done = true;
+        send->payload.clear();
+    }
+    else
+    {
+        send->overlapped.hEvent = WSACreateEvent();
+        if (send->overlapped.hEvent == WSA_INVALID_EVENT)
+        {
+            throw std::runtime_error(GetExceptionString("Failed to create event.", WSAGetLastError()));
+        }
+        WSABUF data;
+        data.len = static_cast<ULONG>(send->payload.size());
+        data.buf = &send->payload[0];
+        if (WSASend(m_socket, &data, 1, nullptr, 0, &send->overlapped, nullptr) == SOCKET_ERROR &&
+            WSAGetLastError() != WSA_IO_PENDING)
+        {
+            int errorCode = WSAGetLastError();
+            WSACloseEvent(send->overlapped.hEvent);
+            throw std::runtime_error(GetExceptionString("Failed to send data.", errorCode));
+        }
+    }
+    m_pendingSends.push_back(std::move(send));
+    return m_nextSendId++;
+}
+
+size_t SocketWrapper::ReapZeroCopyCompletions(std::vector<ZeroCopyCompletion>& completions, bool wait)
+{
+    std::lock_guard<std::mutex> lock(m_zeroCopyMutex);
+    size_t reaped = 0;
+    while (!m_pendingSends.empty())
+    {
+        PendingSend& send = *m_pendingSends.front();
+        if (!send.done)
+        {
+            DWORD dataSent = 0;
+            DWORD flags = 0;
+            if (WSAGetOverlappedResult(m_socket, &send.overlapped, &dataSent, wait ? TRUE : FALSE, &flags))
+            {
+                send.completion.errorCode = 0;
+            }
+            else if (WSAGetLastError() == WSA_IO_INCOMPLETE)
+            {
+                break;
+            }
+            else
+            {
+                send.completion.errorCode = WSAGetLastError();
+            }
+            send.completion.bytesSent = dataSent;
+            WSACloseEvent(send.overlapped.hEvent);
+        }
+        completions.push_back(send.completion);
+        m_pendingSends.pop_front();
+        ++reaped;
+    }
+    return reaped;
+}
+
+UnixSocketWrapper::UnixSocketWrapper()
+    : SocketWrapper(AF_UNIX)
+    , m_lock(INVALID_HANDLE_VALUE)
+{
+}
+
+UnixSocketWrapper::UnixSocketWrapper(SOCKET& other)
+    : SocketWrapper(other)
+    , m_lock(INVALID_HANDLE_VALUE)
+{
+}
+
+UnixSocketWrapper::~UnixSocketWrapper()
+{
+    if (!m_boundPath.empty())
+    {
+        DeleteFileA(m_boundPath.c_str());
+    }
+    if (m_lock != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_lock); // The lock file is deleted on close
+    }
+}
+
+void UnixSocketWrapper::Bind(const std::string&, int16_t port)
+{
+    const std::string path = LocalSocketPath(port);
+    sockaddr_un address = LocalSocketAddress(path);
+    // A live listener keeps the lock file open without sharing, so opening it fails with
+    // a sharing violation. Once the lock is ours, a socket file left by a process which didn't
+    // exit cleanly is stale: nobody listens on it, and it would make bind fail forever.
+    HANDLE lock = CreateFileA((path + ".lock").c_str(), GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (lock == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error(GetExceptionString("Failed to bind socket to address.", GetLastError()));
+    }
+    DeleteFileA(path.c_str());
+    if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR)
+    {
+        int errorCode = WSAGetLastError();
+        CloseHandle(lock);
+        throw std::runtime_error(GetExceptionString("Failed to bind socket to address.", errorCode));
+    }
+    m_boundPath = path;
+    m_lock = lock;
+}
+
+ISocketWrapperPtr UnixSocketWrapper::Connect(const std::string&, int16_t port)
+{
+    sockaddr_un address = LocalSocketAddress(LocalSocketPath(port));
+    if (connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR)
+    {
+        throw std::runtime_error(GetExceptionString("Failed to connect to server.", WSAGetLastError()));
+    }
+
+    WSAPROTOCOL_INFOW info;
+    if (WSADuplicateSocketW(m_socket, GetCurrentProcessId(), &info) == SOCKET_ERROR)
+    {
+        throw std::runtime_error(GetExceptionString("Failed to share connection.", WSAGetLastError()));
+    }
+    SOCKET other = WSASocketW(FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, &info, 0, 0);
+    if (other == INVALID_SOCKET)
+    {
+        throw std::runtime_error(GetExceptionString("Failed to share connection.", WSAGetLastError()));
+    }
+    return std::allocate_shared<UnixSocketWrapper>(PoolAllocator<UnixSocketWrapper>(SessionPool::Default()), other);
+}
+
+bool IsLocalAddress(const std::string& addr)
+{
+    return addr == "localhost" || addr.compare(0, 4, "127.") == 0 || addr == "::1";
+}
+
+ISocketWrapperPtr CreateSocketWrapper(const std::string& addr, LocalTransport localTransport)
+{
+    if (!IsLocalAddress(addr))
+    {
+        return std::make_shared<SocketWrapper>();
+    }
+    if (localTransport == LocalTransport::SharedMemory)
+    {
+        return std::make_shared<SharedMemorySocketWrapper>();
+    }
+    return std::make_shared<UnixSocketWrapper>();
+}
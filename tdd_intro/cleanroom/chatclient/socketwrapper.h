@@ -1,20 +1,101 @@
 #pragma once
 #include "isocketwrapper.h"
 #include <Windows.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Result of a zero-copy send, see SocketWrapper::WriteZeroCopy.
+struct ZeroCopyCompletion
+{
+    uint64_t id;
+    size_t bytesSent;
+    // 0 on success, otherwise the Winsock error of the send.
+    int errorCode;
+};
 
 class SocketWrapper : public ISocketWrapper
 {
 public:
     SocketWrapper();
     explicit SocketWrapper(SOCKET& other);
-    ~SocketWrapper();
+    virtual ~SocketWrapper();
     void Bind(const std::string& addr, int16_t port);
     void Listen();
     ISocketWrapperPtr Accept();
+    // Accepts all pending connections, but not more than maxCount, without waiting for new ones.
+    // Returns an empty list when nobody is waiting. Accepted sockets are not inherited by child processes.
+    // Connections reset by clients before they are accepted are skipped. Other errors throw
+    // std::runtime_error only if nothing is accepted yet, otherwise the accepted connections are returned.
+    std::vector<ISocketWrapperPtr> AcceptMany(size_t maxCount = SOMAXCONN);
     ISocketWrapperPtr Connect(const std::string& addr, int16_t port);
     void Read(std::string& buffer);
+    size_t Read(char* buffer, size_t size);
     void Write(const std::string& buffer);
 
+    // Payloads of at least minSize bytes passed to WriteZeroCopy are sent without copying them
+    // into the socket send buffer. The send buffer is turned off once here, for all writes,
+    // so this mode suits sockets carrying mostly large payloads. 0 turns it off (default).
+    void SetZeroCopyThreshold(size_t minSize);
+    // Starts sending the payload and returns the id of the send. The socket owns the payload
+    // until the stack is done with it, so the call doesn't wait for the data to go out.
+    // Smaller payloads, or all of them with zero-copy off, are sent like Write and complete at once.
+    uint64_t WriteZeroCopy(std::string payload);
+    // Releases payloads of finished zero-copy sends and appends their completions, in the order
+    // of the sends. With wait set, waits for all sends started so far. Returns the number appended.
+    size_t ReapZeroCopyCompletions(std::vector<ZeroCopyCompletion>& completions, bool wait = false);
+
+protected:
+    explicit SocketWrapper(int addressFamily);
+
 private:
+    struct PendingSend;
+
+    void SetNonBlocking(bool nonBlocking);
+
+protected:
     SOCKET m_socket;
+
+private:
+    std::mutex m_zeroCopyMutex;
+    size_t m_zeroCopyThreshold;
+    int m_sendBufferSize;
+    uint64_t m_nextSendId;
+    std::deque<std::unique_ptr<PendingSend>> m_pendingSends;
+};
+
+/*
+ * Stream socket of AF_UNIX family for peers on the same host.
+ * The port is mapped to a socket file in the temporary directory, the address is ignored.
+ * The listener holds a lock file next to it, so Bind fails while another listener is alive
+ * and removes a socket file left by one which didn't exit cleanly, without connecting to it.
+ * The listener removes both files on destruction.
+*/
+class UnixSocketWrapper : public SocketWrapper
+{
+public:
+    UnixSocketWrapper();
+    explicit UnixSocketWrapper(SOCKET& other);
+    ~UnixSocketWrapper();
+    void Bind(const std::string& addr, int16_t port);
+    // This socket stays connected, the returned one shares the same connection.
+    ISocketWrapperPtr Connect(const std::string& addr, int16_t port);
+
+private:
+    std::string m_boundPath;
+    HANDLE m_lock;
 };
+
+enum class LocalTransport
+{
+    UnixSocket,
+    SharedMemory
+};
+
+// Returns true for loopback addresses.
+bool IsLocalAddress(const std::string& addr);
+
+// Creates the socket to talk to the peer at addr: TCP socket for remote peers,
+// localTransport for peers on this host.
+ISocketWrapperPtr CreateSocketWrapper(const std::string& addr, LocalTransport localTransport = LocalTransport::UnixSocket);
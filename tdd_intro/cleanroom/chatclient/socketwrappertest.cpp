@@ -1,6 +1,8 @@
 // Tests for the real SocketWrapper implementation for Windows.
 #include <gtest/gtest.h>
+#include <fstream>
 #include "socketwrapper.h"
+#include "sharedmemorysocketwrapper.h"
 
 TEST(SocketWrapperTest, EstablishConnection)
 {
@@ -25,3 +27,173 @@ TEST(SocketWrapperTest, EstablishConnection)
 
     EXPECT_STREQ(testPhrase, str.c_str());
 }
+
+TEST(SocketWrapperTest, ZeroCopyWriteOfLargePayload)
+{
+    SocketWrapper listener;
+    SocketWrapper client;
+
+    const char* address = "127.0.0.1";
+    const int port = 4444;
+
+    listener.Bind(address, port);
+    listener.Listen();
+    client.Connect(address, port);
+    auto server = listener.Accept();
+
+    const std::string payload(64 * 1024, 'x');
+    auto sender = std::static_pointer_cast<SocketWrapper>(server);
+    sender->SetZeroCopyThreshold(10 * 1024);
+    const uint64_t large = sender->WriteZeroCopy(payload);
+    // Below the threshold: sent like Write, completes at once.
+    const uint64_t small = sender->WriteZeroCopy("tail");
+
+    std::string received;
+    std::string portion;
+    while (received.size() < payload.size() + 4)
+    {
+        client.Read(portion);
+        received += portion;
+    }
+
+    std::vector<ZeroCopyCompletion> completions;
+    EXPECT_EQ(2, sender->ReapZeroCopyCompletions(completions, true));
+    ASSERT_EQ(2, completions.size());
+    EXPECT_EQ(large, completions[0].id);
+    EXPECT_EQ(payload.size(), completions[0].bytesSent);
+    EXPECT_EQ(0, completions[0].errorCode);
+    EXPECT_EQ(small, completions[1].id);
+    EXPECT_EQ(4, completions[1].bytesSent);
+    EXPECT_EQ(payload + "tail", received);
+}
+
+TEST(SocketWrapperTest, LocalTransportsAreSelectedForLoopback)
+{
+    EXPECT_TRUE(std::dynamic_pointer_cast<UnixSocketWrapper>(CreateSocketWrapper("127.0.0.1")));
+    EXPECT_TRUE(std::dynamic_pointer_cast<SharedMemorySocketWrapper>(CreateSocketWrapper("127.0.0.1", LocalTransport::SharedMemory)));
+    auto remote = CreateSocketWrapper("192.168.0.1");
+    EXPECT_TRUE(std::dynamic_pointer_cast<SocketWrapper>(remote));
+    EXPECT_FALSE(std::dynamic_pointer_cast<UnixSocketWrapper>(remote));
+}
+
+TEST(SocketWrapperTest, EstablishUnixSocketConnection)
+{
+    UnixSocketWrapper listener;
+    UnixSocketWrapper client;
+
+    const char* address = "127.0.0.1";
+    const int port = 4445;
+
+    listener.Bind(address, port);
+    listener.Listen();
+    client.Connect(address, port);
+    auto server = listener.Accept();
+
+    const char* testPhrase = "bla-bla-bla";
+
+    server->Write(testPhrase);
+    std::string str;
+    client.Read(str);
+
+    EXPECT_STREQ(testPhrase, str.c_str());
+}
+
+TEST(SocketWrapperTest, UnixSocketBindsOverStaleSocketFile)
+{
+    const int port = 4448;
+    char tempPath[MAX_PATH + 1] = {};
+    GetTempPathA(sizeof(tempPath), tempPath);
+    std::ofstream(std::string(tempPath) + "chatclient-" + std::to_string(port) + ".sock") << "left by a crashed process";
+
+    UnixSocketWrapper listener;
+    UnixSocketWrapper client;
+    listener.Bind("127.0.0.1", port);
+    listener.Listen();
+    client.Connect("127.0.0.1", port);
+    EXPECT_TRUE(listener.Accept() != nullptr);
+}
+
+TEST(SocketWrapperTest, UnixSocketKeepsLiveListener)
+{
+    const int port = 4449;
+    UnixSocketWrapper listener;
+    listener.Bind("127.0.0.1", port);
+    listener.Listen();
+    EXPECT_THROW(UnixSocketWrapper().Bind("127.0.0.1", port), std::runtime_error);
+
+    // The failed Bind neither connected to the listener nor removed its socket file.
+    UnixSocketWrapper client;
+    client.Connect("127.0.0.1", port);
+    auto server = listener.Accept();
+    server->Write("bla-bla-bla");
+    std::string str;
+    client.Read(str);
+    EXPECT_EQ("bla-bla-bla", str);
+}
+
+TEST(SocketWrapperTest, EstablishSharedMemoryConnection)
+{
+    SharedMemorySocketWrapper listener;
+    SharedMemorySocketWrapper client;
+
+    const char* address = "127.0.0.1";
+    const int port = 4446;
+
+    listener.Bind(address, port);
+    EXPECT_THROW(SharedMemorySocketWrapper().Bind(address, port), std::runtime_error);
+    listener.Listen();
+    client.Connect(address, port);
+    auto server = listener.Accept();
+
+    const char* testPhrase = "bla-bla-bla";
+
+    server->Write(testPhrase);
+    std::string str;
+    client.Read(str);
+
+    EXPECT_STREQ(testPhrase, str.c_str());
+}
+
+TEST(SocketWrapperTest, SharedMemoryRejectsSecondPeer)
+{
+    SharedMemorySocketWrapper listener;
+    SharedMemorySocketWrapper client;
+
+    const char* address = "127.0.0.1";
+    const int port = 4450;
+
+    listener.Bind(address, port);
+    listener.Listen();
+    client.Connect(address, port);
+    EXPECT_THROW(SharedMemorySocketWrapper().Connect(address, port), std::runtime_error);
+    EXPECT_TRUE(listener.Accept() != nullptr);
+}
+
+TEST(SocketWrapperTest, AcceptManyDrainsPendingConnections)
+{
+    SocketWrapper listener;
+    SocketWrapper clients[3];
+
+    const char* address = "127.0.0.1";
+    const int port = 4447;
+
+    listener.Bind(address, port);
+    listener.Listen();
+    EXPECT_TRUE(listener.AcceptMany().empty());
+    for (SocketWrapper& client : clients)
+    {
+        client.Connect(address, port);
+    }
+
+    auto servers = listener.AcceptMany();
+    ASSERT_EQ(3, servers.size());
+    EXPECT_TRUE(listener.AcceptMany().empty());
+
+    const char* testPhrase = "bla-bla-bla";
+
+    servers.back()->Write(testPhrase);
+    std::string str;
+    clients[2].Read(str);
+
+    EXPECT_STREQ(testPhrase, str.c_str());
+}
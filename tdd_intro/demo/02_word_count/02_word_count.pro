@@ -1,10 +1,25 @@
 include(../../gtest.pri)
 
 TEMPLATE = app
-CONFIG += console c++11
+CONFIG += console c++17
 CONFIG -= app_bundle
 CONFIG -= qt
 
+DEFINES += NOMINMAX
+
 SOURCES += \
     test.cpp
 
+HEADERS += \
+    wordcount.h \
+    wordmap.h \
+    stringarena.h \
+    wordscanner.h \
+    parallelwordcount.h \
+    mappedfile.h \
+    heavyhitters.h \
+    stringinterner.h \
+    wordcounter.h \
+    hyperloglog.h \
+    frequencyexport.h
+
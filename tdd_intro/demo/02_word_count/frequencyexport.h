@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "stringinterner.h"
+
+/*
+ * Export of counted words from the most frequent one.
+ *
+ * Words are ordered by a parallel LSD radix sort on (count, id) pairs: 8 bit digits of the count,
+ * every thread histograms and scatters its own part of the array, so a pass is stable
+ * and no thread waits for another. Passes where all counts share the digit are skipped,
+ * real counts rarely need more than 3 of the 8 passes.
+ * For top N only the words with at least the N-th largest count are sorted.
+ * Words with equal counts come in the order of their ids, which is the order of first occurrence.
+ */
+namespace FrequencyExport
+{
+    typedef StringInterner::Id Id;
+
+    struct Item
+    {
+        // Inverted count, ascending keys are descending counts.
+        uint64_t key;
+        Id id;
+    };
+
+    // Calls function(part) for parts 0..parts-1, all but the first one on their own threads.
+    template <typename Function>
+    void ParallelFor(size_t parts, Function function)
+    {
+        std::vector<std::thread> workers;
+        for (size_t part = 1; part < parts; ++part)
+        {
+            workers.emplace_back(function, part);
+        }
+        function(0);
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // One stable pass by the digit at shift. Returns false, leaving output untouched, if all items share the digit.
+    inline bool RadixPass(const std::vector<Item>& input, std::vector<Item>& output, unsigned shift, size_t parts)
+    {
+        const size_t size = input.size();
+        std::vector<std::array<size_t, 256>> offsets(parts);
+        ParallelFor(parts, [&](size_t part)
+        {
+            std::array<size_t, 256>& histogram = offsets[part];
+            histogram.fill(0);
+            for (size_t i = size * part / parts; i < size * (part + 1) / parts; ++i)
+            {
+                ++histogram[(input[i].key >> shift) & 0xff];
+            }
+        });
+
+        // Items of part p with digit d go after items with smaller digits and after parts before p with digit d.
+        size_t position = 0;
+        for (size_t digit = 0; digit < 256; ++digit)
+        {
+            for (size_t part = 0; part < parts; ++part)
+            {
+                const size_t count = offsets[part][digit];
+                if (count == size)
+                {
+                    return false;
+                }
+                offsets[part][digit] = position;
+                position += count;
+            }
+        }
+
+        ParallelFor(parts, [&](size_t part)
+        {
+            std::array<size_t, 256>& next = offsets[part];
+            for (size_t i = size * part / parts; i < size * (part + 1) / parts; ++i)
+            {
+                output[next[(input[i].key >> shift) & 0xff]++] = input[i];
+            }
+        });
+        return true;
+    }
+
+    // Returns ids of at most topN words with the largest counts, from the most frequent.
+    inline std::vector<Id> SortByFrequency(const std::vector<size_t>& counts, size_t topN = std::numeric_limits<size_t>::max(),
+                                           size_t threads = std::thread::hardware_concurrency())
+    {
+        size_t threshold = 0;
+        if (topN < counts.size())
+        {
+            if (topN == 0)
+            {
+                return std::vector<Id>();
+            }
+            std::vector<size_t> largest(counts);
+            std::nth_element(largest.begin(), largest.begin() + (topN - 1), largest.end(), std::greater<size_t>());
+            threshold = largest[topN - 1];
+        }
+
+        std::vector<Item> items;
+        for (Id id = 0; id < counts.size(); ++id)
+        {
+            if (counts[id] >= threshold)
+            {
+                items.push_back(Item{~static_cast<uint64_t>(counts[id]), id});
+            }
+        }
+
+        // Threads are worth starting only for large arrays.
+        const size_t minPartSize = 64 * 1024;
+        const size_t parts = std::max<size_t>(1, std::min<size_t>(threads, items.size() / minPartSize));
+        std::vector<Item> buffer(items.size());
+        for (unsigned shift = 0; shift < 64; shift += 8)
+        {
+            if (RadixPass(items, buffer, shift, parts))
+            {
+                items.swap(buffer);
+            }
+        }
+
+        std::vector<Id> ids;
+        ids.reserve(std::min(items.size(), topN));
+        for (size_t i = 0; i < items.size() && i < topN; ++i)
+        {
+            ids.push_back(items[i].id);
+        }
+        return ids;
+    }
+
+    // Writes "word: count" lines from the most frequent word, through a fixed size buffer.
+    inline void Write(std::ostream& output, const InternedWordCounter& counter, size_t topN = std::numeric_limits<size_t>::max(),
+                      size_t threads = std::thread::hardware_concurrency())
+    {
+        std::string buffer;
+        buffer.reserve(64 * 1024);
+        for (Id id : SortByFrequency(counter.Counts(), topN, threads))
+        {
+            buffer.append(counter.Word(id));
+            buffer.append(": ");
+            buffer.append(std::to_string(counter.Count(id)));
+            buffer.push_back('\n');
+            if (buffer.size() >= 60 * 1024)
+            {
+                output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    // Throws std::runtime_error if the file can't be written.
+    inline void WriteFile(const std::string& path, const InternedWordCounter& counter, size_t topN = std::numeric_limits<size_t>::max(),
+                          size_t threads = std::thread::hardware_concurrency())
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw std::runtime_error("Failed to open " + path + " for writing.");
+        }
+        Write(file, counter, topN, threads);
+        file.flush();
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write " + path + ".");
+        }
+    }
+}
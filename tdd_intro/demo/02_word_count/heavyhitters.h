@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "wordscanner.h"
+
+/*
+ * Approximate counting of the most frequent words in fixed memory.
+ *
+ * CountMinSketch keeps depth rows of width counters, a word increments one counter per row
+ * and its estimate is the smallest of them. Estimates never undercount and, with probability
+ * 1 - delta, overcount by at most epsilon * total. Conservative update raises only the counters
+ * that are below the new estimate, which makes overcounting much smaller in practice.
+ *
+ * TopWords keeps the K words with the largest estimates in a min-heap: a word enters
+ * when its estimate beats the least frequent word kept.
+ */
+
+class CountMinSketch
+{
+public:
+    // Width is rounded up to a power of two.
+    CountMinSketch(size_t width, size_t depth)
+        : m_mask(RoundUpToPowerOfTwo(width) - 1)
+        , m_depth(depth ? depth : 1)
+        , m_counters((m_mask + 1) * m_depth)
+        , m_total(0)
+    {
+    }
+
+    // Sized for estimates within epsilon * total with probability 1 - delta.
+    static CountMinSketch ForError(double epsilon, double delta)
+    {
+        return CountMinSketch(static_cast<size_t>(std::ceil(std::exp(1.0) / epsilon)),
+                              static_cast<size_t>(std::ceil(std::log(1.0 / delta))));
+    }
+
+    // Adds count occurrences of the word and returns its new estimate.
+    uint64_t Add(std::string_view word, uint64_t count = 1)
+    {
+        m_total += count;
+        const uint64_t hash = Hash(word);
+        const uint64_t estimate = Estimate(hash) + count;
+        for (size_t row = 0; row < m_depth; ++row)
+        {
+            uint64_t& counter = m_counters[Index(hash, row)];
+            counter = std::max(counter, estimate);
+        }
+        return estimate;
+    }
+
+    uint64_t Estimate(std::string_view word) const
+    {
+        return Estimate(Hash(word));
+    }
+
+    uint64_t Total() const { return m_total; }
+    size_t Width() const { return m_mask + 1; }
+    size_t Depth() const { return m_depth; }
+    size_t MemoryUsage() const { return m_counters.size() * sizeof(uint64_t); }
+
+private:
+    static size_t RoundUpToPowerOfTwo(size_t value)
+    {
+        size_t power = 1;
+        while (power < value)
+        {
+            power *= 2;
+        }
+        return power;
+    }
+
+    static uint64_t Hash(std::string_view word)
+    {
+        return static_cast<uint64_t>(std::hash<std::string_view>()(word));
+    }
+
+    // Rows use hashes h1 + row * h2, two hashes are enough for independent rows.
+    size_t Index(uint64_t hash, size_t row) const
+    {
+        const uint64_t second = (hash * 0x9e3779b97f4a7c15ull) >> 32 | 1;
+        return row * (m_mask + 1) + static_cast<size_t>((hash + row * second) & m_mask);
+    }
+
+    uint64_t Estimate(uint64_t hash) const
+    {
+        uint64_t estimate = m_counters[Index(hash, 0)];
+        for (size_t row = 1; row < m_depth; ++row)
+        {
+            estimate = std::min(estimate, m_counters[Index(hash, row)]);
+        }
+        return estimate;
+    }
+
+private:
+    size_t m_mask;
+    size_t m_depth;
+    std::vector<uint64_t> m_counters;
+    uint64_t m_total;
+};
+
+class TopWords
+{
+public:
+    typedef std::pair<std::string, uint64_t> Entry;
+
+    explicit TopWords(size_t k)
+        : m_k(k)
+    {
+        m_entries.reserve(k);
+        m_heap.reserve(k);
+    }
+
+    // Records that the word is now estimated to occur count times. Counts of a word only grow.
+    void Update(std::string_view word, uint64_t count)
+    {
+        auto found = m_positions.find(word);
+        if (found != m_positions.end())
+        {
+            m_entries[m_heap[found->second]].second = count;
+            SiftDown(found->second);
+            return;
+        }
+        if (m_heap.size() < m_k)
+        {
+            m_entries.emplace_back(std::string(word), count);
+            m_heap.push_back(m_entries.size() - 1);
+            m_positions.emplace(m_entries.back().first, m_heap.size() - 1);
+            SiftUp(m_heap.size() - 1);
+            return;
+        }
+        if (m_k == 0 || count <= m_entries[m_heap[0]].second)
+        {
+            return;
+        }
+
+        // Replaces the least frequent word.
+        Entry& least = m_entries[m_heap[0]];
+        m_positions.erase(least.first);
+        least.first = word;
+        least.second = count;
+        m_positions.emplace(least.first, 0);
+        SiftDown(0);
+    }
+
+    // Words ordered from the most frequent.
+    std::vector<Entry> Sorted() const
+    {
+        std::vector<Entry> sorted(m_entries);
+        std::sort(sorted.begin(), sorted.end(), [](const Entry& left, const Entry& right)
+        {
+            return left.second != right.second ? left.second > right.second : left.first < right.first;
+        });
+        return sorted;
+    }
+
+private:
+    uint64_t CountAt(size_t position) const { return m_entries[m_heap[position]].second; }
+
+    void Swap(size_t left, size_t right)
+    {
+        std::swap(m_heap[left], m_heap[right]);
+        m_positions.find(m_entries[m_heap[left]].first)->second = left;
+        m_positions.find(m_entries[m_heap[right]].first)->second = right;
+    }
+
+    void SiftUp(size_t position)
+    {
+        while (position > 0 && CountAt(position) < CountAt((position - 1) / 2))
+        {
+            Swap(position, (position - 1) / 2);
+            position = (position - 1) / 2;
+        }
+    }
+
+    void SiftDown(size_t position)
+    {
+        for (;;)
+        {
+            size_t least = position;
+            for (size_t child = 2 * position + 1; child <= 2 * position + 2 && child < m_heap.size(); ++child)
+            {
+                if (CountAt(child) < CountAt(least))
+                {
+                    least = child;
+                }
+            }
+            if (least == position)
+            {
+                return;
+            }
+            Swap(position, least);
+            position = least;
+        }
+    }
+
+private:
+    size_t m_k;
+    // Entries don't move, the heap orders their indices.
+    std::vector<Entry> m_entries;
+    std::vector<size_t> m_heap;
+    // Word to its position in the heap.
+    std::map<std::string, size_t, std::less<>> m_positions;
+};
+
+// K most frequent words of a stream, in memory independent of the number of distinct words.
+class HeavyHitters
+{
+public:
+    HeavyHitters(size_t k, double epsilon = 0.0001, double delta = 0.001)
+        : m_sketch(CountMinSketch::ForError(epsilon, delta))
+        , m_top(k)
+        , m_epsilon(epsilon)
+    {
+    }
+
+    void Add(std::string_view word)
+    {
+        m_top.Update(word, m_sketch.Add(word));
+    }
+
+    // Counts lower cased words of the text, like CountWords.
+    void AddText(std::string_view text)
+    {
+        WordScanner::ScanWords(text, [this](std::string_view word) { Add(word); });
+    }
+
+    // Estimated counts are never below the real ones and likely exceed them by at most ErrorBound.
+    std::vector<TopWords::Entry> Top() const { return m_top.Sorted(); }
+    uint64_t Estimate(std::string_view word) const { return m_sketch.Estimate(word); }
+    uint64_t ErrorBound() const { return static_cast<uint64_t>(std::ceil(m_epsilon * m_sketch.Total())); }
+
+private:
+    CountMinSketch m_sketch;
+    TopWords m_top;
+    double m_epsilon;
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "wordscanner.h"
+
+/*
+ * HyperLogLog estimate of the number of distinct words.
+ *
+ * The first precision bits of a word hash pick one of 2^precision registers, the register keeps
+ * the longest run of leading zeros seen in the rest of the hash. The harmonic mean of the registers
+ * gives the estimate with standard error 1.04 / sqrt(2^precision): 1.6% in 4 KB for precision 12.
+ * Sketches of the same precision merge by taking register maximums, so parts of a corpus
+ * may be counted on different threads or machines and combined.
+ */
+class HyperLogLog
+{
+public:
+    // Throws std::invalid_argument if precision is not in [4, 18].
+    explicit HyperLogLog(unsigned precision = 12)
+        : m_precision(precision)
+    {
+        if (precision < 4 || precision > 18)
+        {
+            throw std::invalid_argument("HyperLogLog precision must be from 4 to 18, got " + std::to_string(precision) + ".");
+        }
+        m_registers.resize(size_t(1) << precision);
+    }
+
+    void Add(std::string_view word)
+    {
+        const uint64_t hash = Mix(static_cast<uint64_t>(std::hash<std::string_view>()(word)));
+        const size_t index = static_cast<size_t>(hash >> (64 - m_precision));
+        // A bit below the remaining ones bounds the rank when they are all zeros.
+        const uint64_t rest = (hash << m_precision) | (uint64_t(1) << (m_precision - 1));
+        const uint8_t rank = static_cast<uint8_t>(CountLeadingZeros(rest) + 1);
+        if (m_registers[index] < rank)
+        {
+            m_registers[index] = rank;
+        }
+    }
+
+    // Adds lower cased words of the text, like CountWords.
+    void AddText(std::string_view text)
+    {
+        WordScanner::ScanWords(text, [this](std::string_view word) { Add(word); });
+    }
+
+    // Throws std::invalid_argument if precisions differ.
+    void Merge(const HyperLogLog& other)
+    {
+        if (other.m_precision != m_precision)
+        {
+            throw std::invalid_argument("Can't merge HyperLogLog sketches of different precision.");
+        }
+        for (size_t i = 0; i < m_registers.size(); ++i)
+        {
+            if (m_registers[i] < other.m_registers[i])
+            {
+                m_registers[i] = other.m_registers[i];
+            }
+        }
+    }
+
+    double Estimate() const
+    {
+        const double registers = static_cast<double>(m_registers.size());
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t rank : m_registers)
+        {
+            sum += std::ldexp(1.0, -rank);
+            zeros += rank == 0 ? 1 : 0;
+        }
+        const double alpha = 0.7213 / (1 + 1.079 / registers);
+        const double estimate = alpha * registers * registers / sum;
+        if (estimate <= 2.5 * registers && zeros != 0)
+        {
+            // Few words: linear counting of empty registers is more precise.
+            return registers * std::log(registers / zeros);
+        }
+        return estimate;
+    }
+
+    unsigned Precision() const { return m_precision; }
+    size_t MemoryUsage() const { return m_registers.size(); }
+
+private:
+    // Spreads hashes which vary only in low bits, std::hash is not required to.
+    static uint64_t Mix(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static unsigned CountLeadingZeros(uint64_t value)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_clzll(value));
+#elif defined(_MSC_VER)
+        unsigned long index = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanReverse64(&index, value);
+#else
+        if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+        {
+            index += 32;
+        }
+        else
+        {
+            _BitScanReverse(&index, static_cast<unsigned long>(value));
+        }
+#endif
+        return 63 - static_cast<unsigned>(index);
+#else
+        unsigned count = 0;
+        while (!(value & (uint64_t(1) << 63)))
+        {
+            value <<= 1;
+            ++count;
+        }
+        return count;
+#endif
+    }
+
+private:
+    unsigned m_precision;
+    std::vector<uint8_t> m_registers;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "parallelwordcount.h"
+
+/*
+ * Read only memory mapping of a whole file.
+ *
+ * The text is tokenized right from the mapping, it is never copied to a string.
+ * The mapping is marked for sequential access, so the kernel reads ahead and drops
+ * pages behind the reader; Release lets the pages of counted text go right away,
+ * so resident memory stays low even for files larger than RAM.
+ */
+class MappedFile
+{
+public:
+    // Throws std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string& path)
+        : m_data(nullptr)
+        , m_size(0)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Failed to open " + path + ". Error: " + std::to_string(GetLastError()));
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            DWORD error = GetLastError();
+            CloseHandle(file);
+            throw std::runtime_error("Failed to get size of " + path + ". Error: " + std::to_string(error));
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size != 0)
+        {
+            // The view keeps the mapping and the file open.
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            m_data = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            DWORD error = GetLastError();
+            if (mapping)
+            {
+                CloseHandle(mapping);
+            }
+            if (!m_data)
+            {
+                CloseHandle(file);
+                throw std::runtime_error("Failed to map " + path + ". Error: " + std::to_string(error));
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file == -1)
+        {
+            throw std::runtime_error("Failed to open " + path + ". Error: " + std::to_string(errno));
+        }
+        struct stat status;
+        if (fstat(file, &status) == -1)
+        {
+            int error = errno;
+            close(file);
+            throw std::runtime_error("Failed to get size of " + path + ". Error: " + std::to_string(error));
+        }
+        m_size = static_cast<size_t>(status.st_size);
+        if (m_size != 0)
+        {
+            void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data == MAP_FAILED)
+            {
+                int error = errno;
+                close(file);
+                throw std::runtime_error("Failed to map " + path + ". Error: " + std::to_string(error));
+            }
+            madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(data);
+        }
+        close(file);
+#endif
+    }
+
+    ~MappedFile()
+    {
+        if (!m_data)
+        {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    std::string_view View() const { return std::string_view(m_data, m_size); }
+
+    // Hints that the text up to offset + size won't be read anymore, so its pages may leave memory.
+    // The text stays readable, it is read from the file again if touched.
+    void Release(size_t offset, size_t size) const
+    {
+        const size_t page = PageSize();
+        const size_t begin = offset / page * page;
+        const size_t end = offset + size < m_size ? (offset + size) / page * page : m_size;
+        if (!m_data || begin >= end)
+        {
+            return;
+        }
+#ifdef _WIN32
+        // Unlocking pages which are not locked removes them from the working set.
+        VirtualUnlock(const_cast<char*>(m_data + begin), end - begin);
+#else
+        madvise(const_cast<char*>(m_data + begin), end - begin, MADV_DONTNEED);
+#endif
+    }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    static size_t PageSize()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+// Returns the end of the window starting at begin: the first separator after windowSize bytes, so no word is cut.
+inline size_t WindowEnd(std::string_view text, size_t begin, size_t windowSize)
+{
+    return text.size() - begin > windowSize ? WordScanner::FindSeparator(text, begin + windowSize) : text.size();
+}
+
+// Counts words of the file window by window, releasing every window once it is counted.
+inline WordMap CountWordsInFile(const std::string& path, size_t threads = std::thread::hardware_concurrency(),
+                                size_t windowSize = 64 * 1024 * 1024)
+{
+    MappedFile file(path);
+    const std::string_view text = file.View();
+    WordMap counts;
+
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        const size_t end = WindowEnd(text, begin, windowSize);
+        WordMap windowCounts = CountWordsParallel(text.substr(begin, end - begin), threads);
+        MergeInto(counts, windowCounts);
+        file.Release(begin, end - begin);
+        begin = end;
+    }
+    return counts;
+}
+
+inline words_mt SeparateWordsInFile(const std::string& path)
+{
+    return ToWordsMap(CountWordsInFile(path));
+}
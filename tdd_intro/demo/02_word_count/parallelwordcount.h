@@ -0,0 +1,91 @@
+#pragma once
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "wordcount.h"
+
+/*
+ * Map-reduce word count over all cores.
+ *
+ * The text is split into one chunk per thread, each chunk ends on a separator so no word is cut.
+ * Every thread counts its chunk into its own WordMap, without sharing anything with other threads,
+ * then the maps are merged pairwise in parallel: log2(threads) rounds instead of one thread merging all.
+ * Small texts are counted on fewer threads, starting threads costs more than counting them.
+ */
+
+// Splits text into at most parts chunks, every chunk but the last one ends on a separator.
+inline std::vector<std::string_view> SplitOnWords(std::string_view text, size_t parts)
+{
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (size_t part = 1; part <= parts && begin < text.size(); ++part)
+    {
+        size_t end = part == parts ? text.size() : text.size() / parts * part;
+        if (end < begin)
+        {
+            end = begin;
+        }
+        end = WordScanner::FindSeparator(text, end);
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+// Merges the smaller map into the larger one, leaves the result in target and frees source.
+inline void MergeInto(WordMap& target, WordMap& source)
+{
+    if (target.Size() < source.Size())
+    {
+        std::swap(target, source);
+    }
+    target.Merge(source);
+    source = WordMap();
+}
+
+inline WordMap CountWordsParallel(std::string_view phrase, size_t threads = std::thread::hardware_concurrency())
+{
+    const size_t minChunkSize = 256 * 1024;
+    if (threads > phrase.size() / minChunkSize)
+    {
+        threads = phrase.size() / minChunkSize;
+    }
+    if (threads < 2)
+    {
+        return CountWords(phrase);
+    }
+
+    const std::vector<std::string_view> chunks = SplitOnWords(phrase, threads);
+    std::vector<WordMap> counts(chunks.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunks.size(); ++i)
+    {
+        workers.emplace_back([&counts, &chunks, i]() { counts[i] = CountWords(chunks[i]); });
+    }
+    counts[0] = CountWords(chunks[0]);
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    for (size_t step = 1; step < counts.size(); step *= 2)
+    {
+        workers.clear();
+        for (size_t i = 2 * step; i + step < counts.size(); i += 2 * step)
+        {
+            workers.emplace_back([&counts, i, step]() { MergeInto(counts[i], counts[i + step]); });
+        }
+        MergeInto(counts[0], counts[step]);
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+    return std::move(counts[0]);
+}
+
+inline words_mt SeparateWordsParallel(std::string_view phrase, size_t threads = std::thread::hardware_concurrency())
+{
+    return ToWordsMap(CountWordsParallel(phrase, threads));
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+ * Bump allocator for strings which live as long as the arena.
+ *
+ * Strings are copied back to back into large chunks, so storing one is a pointer bump
+ * and neighbouring words share cache lines. Chunks never move, views stay valid until the arena dies.
+ */
+class StringArena
+{
+public:
+    explicit StringArena(size_t chunkSize = 64 * 1024)
+        : m_chunkSize(chunkSize)
+        , m_current(nullptr)
+        , m_used(chunkSize)
+        , m_bytes(0)
+        , m_reserved(0)
+    {
+    }
+
+    // Returns a copy of text stored in the arena.
+    std::string_view Store(std::string_view text)
+    {
+        m_bytes += text.size();
+        if (text.size() > m_chunkSize)
+        {
+            // Too large to share a chunk, gets its own one.
+            m_chunks.emplace_back(new char[text.size()]);
+            m_reserved += text.size();
+            std::memcpy(m_chunks.back().get(), text.data(), text.size());
+            return std::string_view(m_chunks.back().get(), text.size());
+        }
+        if (m_chunkSize - m_used < text.size())
+        {
+            m_chunks.emplace_back(new char[m_chunkSize]);
+            m_reserved += m_chunkSize;
+            m_current = m_chunks.back().get();
+            m_used = 0;
+        }
+        char* copy = m_current + m_used;
+        std::memcpy(copy, text.data(), text.size());
+        m_used += text.size();
+        return std::string_view(copy, text.size());
+    }
+
+    // Bytes of stored strings.
+    size_t Bytes() const { return m_bytes; }
+    // Bytes allocated for chunks.
+    size_t Reserved() const { return m_reserved; }
+
+private:
+    size_t m_chunkSize;
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    char* m_current;
+    size_t m_used;
+    size_t m_bytes;
+    size_t m_reserved;
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "stringarena.h"
+#include "wordcount.h"
+
+/*
+ * String interning for word counting.
+ *
+ * Every distinct word is stored once in a StringArena and gets a dense 32 bit id:
+ * the first new word is 0, the next one 1 and so on. The lookup table holds only ids,
+ * 4 bytes per slot, and compares keys only when the saved hashes match.
+ * Anything keyed by word can then be a plain vector indexed by id.
+ */
+class StringInterner
+{
+public:
+    typedef uint32_t Id;
+    static constexpr Id notFound = ~Id(0);
+
+    StringInterner()
+        : m_table(s_minCapacity, notFound)
+    {
+    }
+
+    // Returns the id of the word, adding the word if it is new.
+    Id Intern(std::string_view word)
+    {
+        if ((m_words.size() + 1) * 4 > m_table.size() * 3)
+        {
+            Grow();
+        }
+        const uint64_t hash = Hash(word);
+        Id& slot = m_table[Find(word, hash)];
+        if (slot == notFound)
+        {
+            slot = static_cast<Id>(m_words.size());
+            m_words.push_back(m_arena.Store(word));
+            m_hashes.push_back(hash);
+        }
+        return slot;
+    }
+
+    // Returns notFound for words which were not interned.
+    Id Find(std::string_view word) const
+    {
+        return m_table[Find(word, Hash(word))];
+    }
+
+    // The view is valid as long as the interner.
+    std::string_view Word(Id id) const { return m_words[id]; }
+    size_t Size() const { return m_words.size(); }
+    const StringArena& Arena() const { return m_arena; }
+
+private:
+    static const size_t s_minCapacity = 16;
+
+    static uint64_t Hash(std::string_view word)
+    {
+        return static_cast<uint64_t>(std::hash<std::string_view>()(word));
+    }
+
+    // Returns the table slot holding the word or the empty slot where it belongs.
+    size_t Find(std::string_view word, uint64_t hash) const
+    {
+        const size_t mask = m_table.size() - 1;
+        for (size_t index = static_cast<size_t>(hash) & mask; ; index = (index + 1) & mask)
+        {
+            const Id id = m_table[index];
+            if (id == notFound || (m_hashes[id] == hash && m_words[id] == word))
+            {
+                return index;
+            }
+        }
+    }
+
+    // Rehashes from saved hashes, words are not touched.
+    void Grow()
+    {
+        std::vector<Id> table(m_table.size() * 2, notFound);
+        const size_t mask = table.size() - 1;
+        for (Id id = 0; id < m_words.size(); ++id)
+        {
+            size_t index = static_cast<size_t>(m_hashes[id]) & mask;
+            while (table[index] != notFound)
+            {
+                index = (index + 1) & mask;
+            }
+            table[index] = id;
+        }
+        m_table.swap(table);
+    }
+
+private:
+    StringArena m_arena;
+    std::vector<std::string_view> m_words;
+    std::vector<uint64_t> m_hashes;
+    std::vector<Id> m_table;
+};
+
+// Word counter keyed by interned ids: counts are a vector indexed by id.
+class InternedWordCounter
+{
+public:
+    typedef StringInterner::Id Id;
+
+    Id Add(std::string_view word, size_t count = 1)
+    {
+        const Id id = m_interner.Intern(word);
+        if (id == m_counts.size())
+        {
+            m_counts.push_back(0);
+        }
+        m_counts[id] += count;
+        return id;
+    }
+
+    // Counts lower cased words of the text, like CountWords.
+    void AddText(std::string_view text)
+    {
+        WordScanner::ScanWords(text, [this](std::string_view word) { Add(word); });
+    }
+
+    size_t Count(std::string_view word) const
+    {
+        const Id id = m_interner.Find(word);
+        return id == StringInterner::notFound ? 0 : m_counts[id];
+    }
+
+    size_t Count(Id id) const { return m_counts[id]; }
+    std::string_view Word(Id id) const { return m_interner.Word(id); }
+    size_t Size() const { return m_counts.size(); }
+    const StringInterner& Interner() const { return m_interner; }
+    // Counts indexed by id.
+    const std::vector<size_t>& Counts() const { return m_counts; }
+
+    words_mt ToWordsMap() const
+    {
+        words_mt words;
+        for (Id id = 0; id < m_counts.size(); ++id)
+        {
+            words.emplace(std::string(m_interner.Word(id)), m_counts[id]);
+        }
+        return words;
+    }
+
+private:
+    StringInterner m_interner;
+    std::vector<size_t> m_counts;
+};
@@ -13,48 +13,19 @@ manner: 1
 such: 1
 */
 
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
 #include <gtest/gtest.h>
-#include <string>
-#include <map>
-
-using words_mt = std::map<std::string, size_t>;
-const static char wordSeparator = ' ';
-
-bool TrimWord(std::string& phrase, std::string& word, const char seperator)
-{
-    if (phrase.empty())
-    {
-        return false;
-    }
-
-    size_t index = phrase.find_first_of(seperator);
-    if (index == std::string::npos || index == phrase.size())
-    {
-        word = phrase;
-        phrase.clear();
-    }
-    else
-    {
-        word = phrase.substr(0, index);
-        phrase = phrase.substr(index + 1, phrase.size() - index);
-    }
-
-    return true;
-}
-
-words_mt SeparateWords(const std::string& phrase)
-{
-    words_mt words;
-    std::string currentPhrase = phrase;
-    std::string curentWord;
-
-    while (TrimWord(currentPhrase, curentWord, wordSeparator))
-    {
-        ++words[curentWord];
-    }
-
-    return words;
-}
+#include "wordcount.h"
+#include "parallelwordcount.h"
+#include "mappedfile.h"
+#include "heavyhitters.h"
+#include "stringinterner.h"
+#include "wordcounter.h"
+#include "hyperloglog.h"
+#include "frequencyexport.h"
 
 TEST(WordsCount, TestSeparateFirstWord)
 {
@@ -130,3 +101,486 @@ TEST(WordsCount, AcceptanceTest)
     ASSERT_EQ(1, words["manner"]);
     ASSERT_EQ(1, words["such"]);
 }
+
+TEST(WordsCount, TestRepeatedSeparatorsAreSkipped)
+{
+    words_mt words = SeparateWords("  tdd   course ");
+
+    EXPECT_EQ(2, words.size());
+    EXPECT_EQ(1, words["tdd"]);
+    EXPECT_EQ(1, words["course"]);
+}
+
+TEST(WordsCount, TestLongPhraseIsCountedInLinearTime)
+{
+    std::string phrase;
+    for (int i = 0; i < 1000000; ++i)
+    {
+        phrase += "olly in come free ";
+    }
+
+    words_mt words = SeparateWords(phrase);
+
+    ASSERT_EQ(4, words.size());
+    ASSERT_EQ(1000000, words["olly"]);
+}
+
+TEST(WordsCount, TestWordMapCountsInlineAndLongWords)
+{
+    const std::string longWord(100, 'x');
+    WordMap counts;
+    counts.Add("tdd");
+    counts.Add(longWord);
+    counts.Add("tdd", 2);
+
+    EXPECT_EQ(2, counts.Size());
+    EXPECT_EQ(3, counts.Count("tdd"));
+    EXPECT_EQ(1, counts.Count(longWord));
+    EXPECT_EQ(0, counts.Count("course"));
+}
+
+TEST(WordsCount, TestWordMapKeepsWordsWhenGrowing)
+{
+    WordMap counts;
+    for (int i = 0; i < 100000; ++i)
+    {
+        // Odd words are longer than the inline key.
+        const int word = i % 20000;
+        counts.Add("word" + std::to_string(word) + std::string(word % 2 ? 20 : 0, '-'));
+    }
+
+    EXPECT_EQ(20000, counts.Size());
+    EXPECT_EQ(5, counts.Count("word8"));
+    EXPECT_EQ(5, counts.Count("word7" + std::string(20, '-')));
+    EXPECT_EQ(0, counts.Count("word7"));
+}
+
+TEST(WordsCount, TestWordMapSortedViewMatchesOrderedMap)
+{
+    const std::string phrase = "olly olly in come free please please let it be in such manner olly";
+    WordMap counts = CountWords(phrase);
+    words_mt expected;
+    for (const std::string word : {"olly", "olly", "in", "come", "free", "please", "please", "let", "it", "be", "in", "such", "manner", "olly"})
+    {
+        ++expected[word];
+    }
+
+    std::vector<WordMap::Entry> sorted = counts.SortedView();
+    ASSERT_EQ(expected.size(), sorted.size());
+    auto entry = sorted.begin();
+    for (const auto& word : expected)
+    {
+        EXPECT_EQ(word.first, entry->first);
+        EXPECT_EQ(word.second, entry->second);
+        ++entry;
+    }
+}
+
+TEST(WordsCount, TestSplitOnWordsDoesNotCutWords)
+{
+    std::vector<std::string_view> chunks = SplitOnWords("tdd course olly in come free", 4);
+
+    std::string joined;
+    for (std::string_view chunk : chunks)
+    {
+        EXPECT_TRUE(chunk.empty() || chunk.back() != ' ');
+        joined += chunk;
+    }
+    EXPECT_EQ("tdd course olly in come free", joined);
+    EXPECT_EQ(SeparateWords("tdd course olly in come free"), SeparateWords(joined));
+    EXPECT_LE(chunks.size(), 4);
+}
+
+TEST(WordsCount, TestSplitOnWordsCutsAtAnySeparator)
+{
+    std::string phrase;
+    for (int i = 0; i < 10000; ++i)
+    {
+        phrase += "word" + std::to_string(i % 100) + (i % 2 ? "\n" : ",\t");
+    }
+
+    std::vector<std::string_view> chunks = SplitOnWords(phrase, 8);
+
+    ASSERT_EQ(8, chunks.size());
+    for (size_t i = 1; i < chunks.size(); ++i)
+    {
+        EXPECT_FALSE(WordScanner::IsWordCharacter(chunks[i].front())) << i;
+    }
+    WordMap counts;
+    for (std::string_view chunk : chunks)
+    {
+        counts.Merge(CountWords(chunk));
+    }
+    EXPECT_EQ(SeparateWords(phrase), ToWordsMap(counts));
+}
+
+TEST(WordsCount, TestParallelCountMatchesSingleThreaded)
+{
+    std::string phrase;
+    for (int i = 0; i < 400000; ++i)
+    {
+        phrase += "word" + std::to_string(i % 5000 * (i % 7 + 1)) + ' ';
+    }
+
+    words_mt expected = SeparateWords(phrase);
+    for (size_t threads : {2, 3, 8})
+    {
+        EXPECT_EQ(expected, SeparateWordsParallel(phrase, threads)) << threads << " threads";
+    }
+}
+
+namespace
+{
+    std::string WriteTempFile(const std::string& name, const std::string& content)
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / name).string();
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+        return path;
+    }
+}
+
+TEST(WordsCount, TestFileCountMatchesPhraseCount)
+{
+    const std::string phrase = "olly olly in come free please please let it be in such manner olly";
+    const std::string path = WriteTempFile("word_count_phrase.txt", phrase);
+
+    EXPECT_EQ(SeparateWords(phrase), SeparateWordsInFile(path));
+    std::filesystem::remove(path);
+}
+
+TEST(WordsCount, TestFileIsCountedInWindowsWithoutCuttingWords)
+{
+    std::string phrase;
+    for (int i = 0; i < 100000; ++i)
+    {
+        phrase += "word" + std::to_string(i % 3000) + ' ';
+    }
+    const std::string path = WriteTempFile("word_count_windows.txt", phrase);
+
+    EXPECT_EQ(SeparateWords(phrase), ToWordsMap(CountWordsInFile(path, 2, 4096 + 3)));
+    std::filesystem::remove(path);
+}
+
+TEST(WordsCount, TestFileWindowsEndAtAnySeparator)
+{
+    std::string text;
+    for (int i = 0; i < 10000; ++i)
+    {
+        text += "word" + std::to_string(i % 100) + '\n';
+    }
+
+    const size_t end = WindowEnd(text, 0, 4096);
+
+    EXPECT_LT(end, 4096 + 8);
+    EXPECT_EQ('\n', text[end]);
+    EXPECT_EQ(text.size(), WindowEnd(text, end, text.size()));
+    const std::string path = WriteTempFile("word_count_lines.txt", text);
+    EXPECT_EQ(SeparateWords(text), ToWordsMap(CountWordsInFile(path, 2, 4096)));
+    std::filesystem::remove(path);
+}
+
+TEST(WordsCount, TestEmptyFileHasNoWords)
+{
+    const std::string path = WriteTempFile("word_count_empty.txt", "");
+
+    EXPECT_TRUE(SeparateWordsInFile(path).empty());
+    std::filesystem::remove(path);
+}
+
+TEST(WordsCount, TestMissingFileThrows)
+{
+    EXPECT_THROW(SeparateWordsInFile("no_such_directory/no_such_file.txt"), std::runtime_error);
+}
+
+TEST(WordsCount, TestPunctuationIsIgnoredAndCaseIsFolded)
+{
+    words_mt words = SeparateWords("Olly, olly! In come free.\tPlease:please;\nOLLY");
+
+    ASSERT_EQ(5, words.size());
+    EXPECT_EQ(3, words["olly"]);
+    EXPECT_EQ(1, words["in"]);
+    EXPECT_EQ(2, words["please"]);
+}
+
+TEST(WordsCount, TestWordsAcrossBlocksAreScannedWhole)
+{
+    const std::string longWord(150, 'W');
+    const std::string phrase = std::string(60, '.') + "Crossing " + longWord + " tail";
+    std::vector<std::string> words;
+
+    WordScanner::ScanWords(phrase, [&words](std::string_view word) { words.emplace_back(word); });
+
+    ASSERT_EQ(3, words.size());
+    EXPECT_EQ("crossing", words[0]);
+    EXPECT_EQ(std::string(150, 'w'), words[1]);
+    EXPECT_EQ("tail", words[2]);
+}
+
+TEST(WordsCount, TestVectorClassificationMatchesScalar)
+{
+    char block[WordScanner::blockSize];
+    for (unsigned first = 0; first < 256; first += WordScanner::blockSize)
+    {
+        for (size_t i = 0; i < WordScanner::blockSize; ++i)
+        {
+            block[i] = static_cast<char>(first + i);
+        }
+        char expectedFolded[WordScanner::blockSize];
+        char folded[WordScanner::blockSize];
+        const uint64_t expected = WordScanner::ClassifyBlockScalar(block, expectedFolded);
+
+        EXPECT_EQ(expected, WordScanner::ClassifyBlock(block, folded)) << first;
+        EXPECT_EQ(0, std::memcmp(expectedFolded, folded, WordScanner::blockSize)) << first;
+    }
+
+    char folded[WordScanner::blockSize];
+    std::memcpy(block, "Hi, there-42 \xc3\xa9t\xc3\xa9                                               ", WordScanner::blockSize);
+    EXPECT_EQ(0x3edf3ull, WordScanner::ClassifyBlockScalar(block, folded));
+    EXPECT_EQ("hi, there-42", std::string(folded, 12));
+}
+
+namespace
+{
+    // Words "w<rank>" with frequency proportional to 1 / rank.
+    std::string ZipfText(size_t distinctWords, size_t length, unsigned seed)
+    {
+        std::vector<double> weights;
+        for (size_t rank = 1; rank <= distinctWords; ++rank)
+        {
+            weights.push_back(1.0 / rank);
+        }
+        std::mt19937 random(seed);
+        std::discrete_distribution<size_t> ranks(weights.begin(), weights.end());
+
+        std::string text;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text += "w" + std::to_string(ranks(random) + 1) + ' ';
+        }
+        return text;
+    }
+
+    std::vector<std::pair<std::string, size_t>> ByFrequency(const words_mt& words)
+    {
+        std::vector<std::pair<std::string, size_t>> sorted(words.begin(), words.end());
+        std::stable_sort(sorted.begin(), sorted.end(), [](const auto& left, const auto& right) { return left.second > right.second; });
+        return sorted;
+    }
+}
+
+TEST(WordsCount, TestCountMinSketchNeverUndercounts)
+{
+    const std::string text = ZipfText(10000, 200000, 1);
+    const words_mt exact = SeparateWords(text);
+    CountMinSketch sketch = CountMinSketch::ForError(0.001, 0.01);
+    WordScanner::ScanWords(text, [&sketch](std::string_view word) { sketch.Add(word); });
+
+    size_t beyondBound = 0;
+    for (const auto& word : exact)
+    {
+        const uint64_t estimate = sketch.Estimate(word.first);
+        ASSERT_GE(estimate, word.second) << word.first;
+        beyondBound += estimate - word.second > 0.001 * sketch.Total() ? 1 : 0;
+    }
+    EXPECT_EQ(0, beyondBound);
+    EXPECT_EQ(200000, sketch.Total());
+}
+
+TEST(WordsCount, TestHeavyHittersMatchExactTopWordsOnZipfData)
+{
+    const std::string text = ZipfText(10000, 200000, 2);
+    const auto exact = ByFrequency(SeparateWords(text));
+    HeavyHitters hitters(10, 0.0005, 0.001);
+    hitters.AddText(text);
+
+    const std::vector<TopWords::Entry> top = hitters.Top();
+    ASSERT_EQ(10, top.size());
+    for (size_t i = 0; i < top.size(); ++i)
+    {
+        EXPECT_EQ(exact[i].first, top[i].first) << i;
+        EXPECT_GE(top[i].second, exact[i].second);
+        EXPECT_LE(top[i].second - exact[i].second, hitters.ErrorBound());
+    }
+}
+
+TEST(WordsCount, TestInternerGivesDenseIdsToDistinctWords)
+{
+    StringInterner interner;
+
+    EXPECT_EQ(0, interner.Intern("olly"));
+    EXPECT_EQ(1, interner.Intern("in"));
+    EXPECT_EQ(0, interner.Intern(std::string("olly")));
+    EXPECT_EQ(1, interner.Find("in"));
+    EXPECT_EQ(StringInterner::notFound, interner.Find("come"));
+    EXPECT_EQ("in", interner.Word(1));
+    EXPECT_EQ(2, interner.Size());
+    EXPECT_EQ(6, interner.Arena().Bytes());
+}
+
+TEST(WordsCount, TestInternerStoresWordsContiguously)
+{
+    StringInterner interner;
+    for (int i = 0; i < 100000; ++i)
+    {
+        interner.Intern("word" + std::to_string(i));
+    }
+
+    EXPECT_EQ(100000, interner.Size());
+    EXPECT_EQ(12345, interner.Find("word12345"));
+    EXPECT_EQ("word12345", interner.Word(12345));
+    EXPECT_EQ(interner.Word(12345).data() + interner.Word(12345).size(), interner.Word(12346).data());
+    EXPECT_LT(interner.Arena().Reserved(), interner.Arena().Bytes() + 64 * 1024);
+}
+
+TEST(WordsCount, TestInternedCounterMatchesSeparateWords)
+{
+    const std::string text = ZipfText(5000, 50000, 3);
+    InternedWordCounter counter;
+    counter.AddText(text);
+
+    EXPECT_EQ(SeparateWords(text), counter.ToWordsMap());
+    EXPECT_EQ(counter.Count("w1"), counter.Count(counter.Interner().Find("w1")));
+    EXPECT_EQ(0, counter.Count("absent"));
+}
+
+TEST(WordsCount, TestWordCounterCarriesWordsAcrossChunks)
+{
+    WordCounter counter;
+    counter.Feed("olly ol");
+    EXPECT_EQ(1, counter.Count("olly"));
+
+    counter.Feed("l");
+    counter.Feed("y, in co");
+    EXPECT_EQ(2, counter.Count("olly"));
+    EXPECT_EQ(1, counter.Count("in"));
+    EXPECT_EQ(0, counter.Count("co"));
+
+    counter.Feed("me");
+    counter.Finish();
+    EXPECT_EQ(1, counter.Count("come"));
+    EXPECT_EQ(3, counter.Size());
+}
+
+TEST(WordsCount, TestWordCounterMatchesWholeBufferForAnyChunking)
+{
+    const std::string text = "Olly olly in come free, please please let it be in such manner OLLY " + ZipfText(1000, 20000, 4);
+    const words_mt expected = SeparateWords(text);
+
+    std::mt19937 random(5);
+    for (size_t maxChunk : {1, 7, 64, 4096})
+    {
+        WordCounter counter;
+        std::uniform_int_distribution<size_t> chunkSize(1, maxChunk);
+        for (size_t offset = 0; offset < text.size(); )
+        {
+            const size_t size = std::min(chunkSize(random), text.size() - offset);
+            counter.Feed(std::string_view(text).substr(offset, size));
+            offset += size;
+        }
+        counter.Finish();
+
+        EXPECT_EQ(expected, counter.ToWordsMap()) << maxChunk;
+    }
+}
+
+TEST(WordsCount, TestHyperLogLogErrorAgainstExactDistinctCount)
+{
+    for (size_t distinctWords : {100, 10000, 200000})
+    {
+        std::string text;
+        for (size_t i = 0; i < 2 * distinctWords; ++i)
+        {
+            text += "word" + std::to_string(i % distinctWords) + ' ';
+        }
+        HyperLogLog sketch;
+        sketch.AddText(text);
+
+        const double exact = static_cast<double>(SeparateWords(text).size());
+        const double error = std::abs(sketch.Estimate() - exact) / exact;
+        RecordProperty("relativeErrorFor" + std::to_string(distinctWords), std::to_string(error));
+        // 3 standard errors for precision 12.
+        EXPECT_LT(error, 0.05) << distinctWords << " words estimated as " << sketch.Estimate();
+    }
+    EXPECT_EQ(4096, HyperLogLog().MemoryUsage());
+}
+
+TEST(WordsCount, TestMergedHyperLogLogEqualsSketchOfWholeText)
+{
+    const std::string first = ZipfText(20000, 50000, 6);
+    const std::string second = ZipfText(20000, 50000, 7);
+    HyperLogLog whole;
+    whole.AddText(first + second);
+    HyperLogLog firstPart;
+    firstPart.AddText(first);
+    HyperLogLog secondPart;
+    secondPart.AddText(second);
+
+    firstPart.Merge(secondPart);
+
+    EXPECT_EQ(whole.Estimate(), firstPart.Estimate());
+    EXPECT_THROW(firstPart.Merge(HyperLogLog(10)), std::invalid_argument);
+    EXPECT_THROW(HyperLogLog(2), std::invalid_argument);
+}
+
+TEST(WordsCount, TestEmptyHyperLogLogEstimatesZero)
+{
+    EXPECT_EQ(0, HyperLogLog().Estimate());
+}
+
+TEST(WordsCount, TestExportByFrequencyWritesTopWords)
+{
+    InternedWordCounter counter;
+    counter.AddText("olly olly in come free please please let it be in such manner olly");
+    std::ostringstream output;
+
+    FrequencyExport::Write(output, counter, 3);
+
+    EXPECT_EQ("olly: 3\nin: 2\nplease: 2\n", output.str());
+}
+
+TEST(WordsCount, TestRadixSortMatchesStableSort)
+{
+    std::mt19937 random(8);
+    std::vector<size_t> counts(300000);
+    for (size_t& count : counts)
+    {
+        // Mostly small counts with long tail, as in real texts.
+        count = random() % 7 == 0 ? random() % 100000000 : random() % 300;
+    }
+    std::vector<FrequencyExport::Id> expected(counts.size());
+    for (FrequencyExport::Id id = 0; id < counts.size(); ++id)
+    {
+        expected[id] = id;
+    }
+    std::stable_sort(expected.begin(), expected.end(), [&counts](FrequencyExport::Id left, FrequencyExport::Id right) { return counts[left] > counts[right]; });
+
+    EXPECT_EQ(expected, FrequencyExport::SortByFrequency(counts, counts.size(), 1));
+    EXPECT_EQ(expected, FrequencyExport::SortByFrequency(counts, counts.size(), 4));
+    for (size_t topN : {0, 1, 1000, 299999})
+    {
+        std::vector<FrequencyExport::Id> top(expected.begin(), expected.begin() + topN);
+        EXPECT_EQ(top, FrequencyExport::SortByFrequency(counts, topN, 4)) << topN;
+    }
+}
+
+TEST(WordsCount, TestExportByFrequencyToFile)
+{
+    InternedWordCounter counter;
+    counter.AddText(ZipfText(20000, 100000, 9));
+    std::ostringstream expected;
+    FrequencyExport::Write(expected, counter);
+    const std::string path = (std::filesystem::temp_directory_path() / "word_count_by_frequency.txt").string();
+
+    FrequencyExport::WriteFile(path, counter);
+
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream written;
+    written << file.rdbuf();
+    const std::string lines = written.str();
+    EXPECT_EQ(expected.str(), lines);
+    EXPECT_EQ(counter.Size(), static_cast<size_t>(std::count(lines.begin(), lines.end(), '\n')));
+    file.close();
+    std::filesystem::remove(path);
+    EXPECT_THROW(FrequencyExport::WriteFile("no_such_directory/words.txt", counter), std::runtime_error);
+}
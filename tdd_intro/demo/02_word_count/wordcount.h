@@ -0,0 +1,55 @@
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include "wordmap.h"
+#include "wordscanner.h"
+
+using words_mt = std::map<std::string, size_t, std::less<>>;
+const static char wordSeparator = ' ';
+
+inline bool TrimWord(std::string& phrase, std::string& word, const char seperator)
+{
+    if (phrase.empty())
+    {
+        return false;
+    }
+
+    size_t index = phrase.find_first_of(seperator);
+    if (index == std::string::npos || index == phrase.size())
+    {
+        word = phrase;
+        phrase.clear();
+    }
+    else
+    {
+        word = phrase.substr(0, index);
+        phrase = phrase.substr(index + 1, phrase.size() - index);
+    }
+
+    return true;
+}
+
+// Counts lower cased words, whitespace and punctuation are ignored.
+inline WordMap CountWords(std::string_view phrase)
+{
+    WordMap counts;
+    WordScanner::ScanWords(phrase, [&counts](std::string_view word) { counts.Add(word); });
+    return counts;
+}
+
+// Ordered copy of the counts. Words come sorted, so every insertion is at the end of the map.
+inline words_mt ToWordsMap(const WordMap& counts)
+{
+    words_mt words;
+    for (const WordMap::Entry& entry : counts.SortedView())
+    {
+        words.emplace_hint(words.end(), entry.first, entry.second);
+    }
+    return words;
+}
+
+inline words_mt SeparateWords(std::string_view phrase)
+{
+    return ToWordsMap(CountWords(phrase));
+}
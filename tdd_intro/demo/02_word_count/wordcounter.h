@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "wordcount.h"
+
+/*
+ * Word counter for text arriving in chunks.
+ *
+ * Every chunk is scanned in place up to its last separator; only the word cut by the end
+ * of the chunk is kept until the next chunk completes it. So a chunk costs the same as
+ * a whole buffer of the same size, and memory depends on distinct words, not on the stream length.
+ * Counts are up to date after every Feed, except for the word which is still cut.
+ */
+class WordCounter
+{
+public:
+    void Feed(std::string_view chunk)
+    {
+        if (!m_partial.empty())
+        {
+            size_t end = 0;
+            while (end < chunk.size() && WordScanner::IsWordCharacter(chunk[end]))
+            {
+                ++end;
+            }
+            m_partial.append(chunk.data(), end);
+            if (end == chunk.size())
+            {
+                return;
+            }
+            AddText(m_partial);
+            m_partial.clear();
+            chunk.remove_prefix(end);
+        }
+
+        size_t begin = chunk.size();
+        while (begin > 0 && WordScanner::IsWordCharacter(chunk[begin - 1]))
+        {
+            --begin;
+        }
+        AddText(chunk.substr(0, begin));
+        m_partial.assign(chunk.data() + begin, chunk.size() - begin);
+    }
+
+    // Ends the stream: counts the last word. Feeding after Finish starts a new stream.
+    void Finish()
+    {
+        AddText(m_partial);
+        m_partial.clear();
+    }
+
+    size_t Count(std::string_view word) const { return m_counts.Count(word); }
+    size_t Size() const { return m_counts.Size(); }
+    const WordMap& Counts() const { return m_counts; }
+    words_mt ToWordsMap() const { return ::ToWordsMap(m_counts); }
+
+private:
+    void AddText(std::string_view text)
+    {
+        WordScanner::ScanWords(text, [this](std::string_view word) { m_counts.Add(word); });
+    }
+
+private:
+    WordMap m_counts;
+    // Beginning of the word cut by the end of the last chunk.
+    std::string m_partial;
+};
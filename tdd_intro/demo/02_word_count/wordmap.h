@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "stringarena.h"
+
+/*
+ * Open addressing hash map from word to its count.
+ *
+ * Slots lie in one power of two sized array and collisions are resolved by linear probing,
+ * so a lookup is one hash and usually one cache line. Lookups take string_view and never allocate.
+ * Words up to 16 characters are stored inside the slot, longer ones are copied to
+ * a StringArena, so there are no per word allocations.
+ * Iteration order is unspecified, SortedView gives words in the order of words_mt.
+ */
+class WordMap
+{
+public:
+    typedef std::pair<std::string_view, size_t> Entry;
+
+    WordMap()
+        : m_size(0)
+        , m_slots(s_minCapacity)
+    {
+    }
+
+    // Adds count occurrences of the word.
+    void Add(std::string_view word, size_t count = 1)
+    {
+        if ((m_size + 1) * 4 > m_slots.size() * 3)
+        {
+            Grow();
+        }
+
+        const uint64_t hash = Hash(word);
+        Slot* slot = Probe(m_slots, word, hash);
+        if (slot->tag == s_empty)
+        {
+            slot->tag = TagOf(hash);
+            slot->length = static_cast<uint32_t>(word.size());
+            if (word.size() <= s_inlineSize)
+            {
+                std::memcpy(slot->key.chars, word.data(), word.size());
+            }
+            else
+            {
+                slot->key.pointer = m_keys.Store(word).data();
+            }
+            ++m_size;
+        }
+        slot->count += count;
+    }
+
+    // Adds counts of all words of other.
+    void Merge(const WordMap& other)
+    {
+        other.ForEach([this](std::string_view word, size_t count) { Add(word, count); });
+    }
+
+    // Returns 0 for unknown words.
+    size_t Count(std::string_view word) const
+    {
+        const Slot* slot = Probe(m_slots, word, Hash(word));
+        return slot->tag == s_empty ? 0 : slot->count;
+    }
+
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+
+    // Calls function(word, count) for every word, in unspecified order.
+    template <typename Function>
+    void ForEach(Function function) const
+    {
+        for (const Slot& slot : m_slots)
+        {
+            if (slot.tag != s_empty)
+            {
+                function(slot.Key(), slot.count);
+            }
+        }
+    }
+
+    // Words with counts ordered by word. Views are valid while the map is alive and not modified.
+    std::vector<Entry> SortedView() const
+    {
+        std::vector<Entry> entries;
+        entries.reserve(m_size);
+        ForEach([&entries](std::string_view word, size_t count) { entries.emplace_back(word, count); });
+        std::sort(entries.begin(), entries.end(), [](const Entry& left, const Entry& right) { return left.first < right.first; });
+        return entries;
+    }
+
+private:
+    static const uint32_t s_empty = 0;
+    static const size_t s_inlineSize = 16;
+    static const size_t s_minCapacity = 16;
+
+    struct Slot
+    {
+        uint32_t tag = s_empty;
+        uint32_t length = 0;
+        size_t count = 0;
+        union
+        {
+            char chars[s_inlineSize];
+            const char* pointer;
+        } key{};
+
+        std::string_view Key() const
+        {
+            return std::string_view(length <= s_inlineSize ? key.chars : key.pointer, length);
+        }
+    };
+    static_assert(sizeof(Slot) <= 32, "Slot must stay within half of a cache line");
+
+    static uint64_t Hash(std::string_view word)
+    {
+        return static_cast<uint64_t>(std::hash<std::string_view>()(word));
+    }
+
+    // Low bits of the hash pick the slot, high bits are kept in it to reject most mismatches without comparing keys.
+    static uint32_t TagOf(uint64_t hash)
+    {
+        return static_cast<uint32_t>(hash >> 32) | 1u;
+    }
+
+    // Returns the slot holding the word or the empty slot where it belongs.
+    template <typename Slots>
+    static auto Probe(Slots& slots, std::string_view word, uint64_t hash) -> decltype(&slots[0])
+    {
+        const uint32_t tag = TagOf(hash);
+        const size_t mask = slots.size() - 1;
+        for (size_t index = static_cast<size_t>(hash) & mask; ; index = (index + 1) & mask)
+        {
+            auto* slot = &slots[index];
+            if (slot->tag == s_empty || (slot->tag == tag && slot->Key() == word))
+            {
+                return slot;
+            }
+        }
+    }
+
+    void Grow()
+    {
+        std::vector<Slot> slots(m_slots.size() * 2);
+        const size_t mask = slots.size() - 1;
+        for (const Slot& slot : m_slots)
+        {
+            if (slot.tag == s_empty)
+            {
+                continue;
+            }
+            size_t index = static_cast<size_t>(Hash(slot.Key())) & mask;
+            while (slots[index].tag != s_empty)
+            {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+        m_slots.swap(slots);
+    }
+
+private:
+    size_t m_size;
+    std::vector<Slot> m_slots;
+    StringArena m_keys;
+};
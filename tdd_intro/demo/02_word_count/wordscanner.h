@@ -0,0 +1,202 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WORD_SCANNER_SSE2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * Vectorized word scanner.
+ *
+ * Letters, digits and bytes of multibyte UTF-8 characters make words, whitespace and punctuation separate them.
+ * The text is classified 64 bytes at a time into a bitmask with a bit set for every word character,
+ * and upper case ASCII letters are folded to lower case in the same pass.
+ * Word boundaries are found with bit tricks on the mask, so the loop runs per word rather than per byte.
+ * AVX2 or SSE2 is used when the compiler targets it, otherwise the scalar version.
+ */
+namespace WordScanner
+{
+    const size_t blockSize = 64;
+
+    inline bool IsWordCharacter(char character)
+    {
+        const unsigned char c = static_cast<unsigned char>(character);
+        return static_cast<unsigned>((c | 0x20) - 'a') < 26 || static_cast<unsigned>(c - '0') < 10 || c >= 0x80;
+    }
+
+    // Returns the position of the first separator at or after position, or the size of the text if there is none.
+    inline size_t FindSeparator(std::string_view text, size_t position)
+    {
+        while (position < text.size() && IsWordCharacter(text[position]))
+        {
+            ++position;
+        }
+        return position;
+    }
+
+    // Classifies a block of blockSize bytes and writes it to folded, lower cased.
+    inline uint64_t ClassifyBlockScalar(const char* block, char* folded)
+    {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+            const unsigned char c = static_cast<unsigned char>(block[i]);
+            const bool upper = static_cast<unsigned>(c - 'A') < 26;
+            const bool word = IsWordCharacter(block[i]);
+            folded[i] = static_cast<char>(c | (static_cast<unsigned>(upper) << 5));
+            mask |= static_cast<uint64_t>(word) << i;
+        }
+        return mask;
+    }
+
+#ifdef WORD_SCANNER_SSE2
+    // Bytes in [first, first + count): shifted so the range starts at -128, then one signed compare.
+    inline __m128i InRange(__m128i bytes, char first, char count)
+    {
+        const __m128i shifted = _mm_add_epi8(bytes, _mm_set1_epi8(static_cast<char>(0x80 - first)));
+        return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + count)));
+    }
+
+    inline uint64_t ClassifyBlockSse2(const char* block, char* folded)
+    {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < blockSize; i += 16)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            const __m128i upper = InRange(bytes, 'A', 26);
+            const __m128i word = _mm_or_si128(_mm_or_si128(upper, InRange(bytes, 'a', 26)),
+                                              _mm_or_si128(InRange(bytes, '0', 10), _mm_cmplt_epi8(bytes, _mm_setzero_si128())));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(folded + i), _mm_or_si128(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+            mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(word))) << i;
+        }
+        return mask;
+    }
+#endif
+
+#if defined(__AVX2__)
+    inline __m256i InRange(__m256i bytes, char first, char count)
+    {
+        const __m256i shifted = _mm256_add_epi8(bytes, _mm256_set1_epi8(static_cast<char>(0x80 - first)));
+        return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0x80 + count)), shifted);
+    }
+
+    inline uint64_t ClassifyBlockAvx2(const char* block, char* folded)
+    {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < blockSize; i += 32)
+        {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+            const __m256i upper = InRange(bytes, 'A', 26);
+            const __m256i word = _mm256_or_si256(_mm256_or_si256(upper, InRange(bytes, 'a', 26)),
+                                                 _mm256_or_si256(InRange(bytes, '0', 10), _mm256_cmpgt_epi8(_mm256_setzero_si256(), bytes)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(folded + i), _mm256_or_si256(bytes, _mm256_and_si256(upper, _mm256_set1_epi8(0x20))));
+            mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(word))) << i;
+        }
+        return mask;
+    }
+#endif
+
+    inline uint64_t ClassifyBlock(const char* block, char* folded)
+    {
+#if defined(__AVX2__)
+        return ClassifyBlockAvx2(block, folded);
+#elif defined(WORD_SCANNER_SSE2)
+        return ClassifyBlockSse2(block, folded);
+#else
+        return ClassifyBlockScalar(block, folded);
+#endif
+    }
+
+    inline unsigned CountTrailingZeros(uint64_t mask)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#elif defined(_MSC_VER)
+        unsigned long index = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanForward64(&index, mask);
+#else
+        if (!_BitScanForward(&index, static_cast<unsigned long>(mask)))
+        {
+            _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+            index += 32;
+        }
+#endif
+        return static_cast<unsigned>(index);
+#else
+        unsigned count = 0;
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++count;
+        }
+        return count;
+#endif
+    }
+
+    // Calls onWord(word) for every lower cased word of the text.
+    // The word view is valid only during the call.
+    template <typename OnWord>
+    void ScanWords(std::string_view text, OnWord onWord)
+    {
+        char folded[blockSize];
+        char tail[blockSize];
+        // Beginning of a word which continues in the next block.
+        std::string pending;
+
+        for (size_t offset = 0; offset < text.size(); offset += blockSize)
+        {
+            const char* block = text.data() + offset;
+            if (text.size() - offset < blockSize)
+            {
+                // Separators after the end of the text finish the last word.
+                std::memset(tail, ' ', blockSize);
+                std::memcpy(tail, block, text.size() - offset);
+                block = tail;
+            }
+            uint64_t mask = ClassifyBlock(block, folded);
+
+            if (!pending.empty())
+            {
+                if (mask == ~uint64_t(0))
+                {
+                    pending.append(folded, blockSize);
+                    continue;
+                }
+                const unsigned end = CountTrailingZeros(~mask);
+                pending.append(folded, end);
+                onWord(std::string_view(pending));
+                pending.clear();
+                mask &= ~uint64_t(0) << end;
+            }
+
+            while (mask)
+            {
+                const unsigned begin = CountTrailingZeros(mask);
+                const uint64_t separators = ~mask & (~uint64_t(0) << begin);
+                if (!separators)
+                {
+                    pending.assign(folded + begin, blockSize - begin);
+                    break;
+                }
+                const unsigned end = CountTrailingZeros(separators);
+                onWord(std::string_view(folded + begin, end - begin));
+                mask &= ~uint64_t(0) << end;
+            }
+        }
+
+        if (!pending.empty())
+        {
+            onWord(std::string_view(pending));
+        }
+    }
+}
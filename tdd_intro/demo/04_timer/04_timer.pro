@@ -9,3 +9,11 @@ DEFINES += NOMINMAX
 
 SOURCES += \
     test.cpp
+
+HEADERS += \
+    timer.h \
+    timingwheel.h \
+    cachedtime.h \
+    basictimer.h \
+    timerservice.h \
+    timerset.h
@@ -0,0 +1,67 @@
+#pragma once
+#include "timer.h"
+
+/*
+ * Timer with the clock resolved at compile time.
+ *
+ * Same behavior as Timer, but the clock is a type with static now(), like std::chrono clocks,
+ * and nothing is virtual, so the whole expiry check is inlined into hot loops.
+ * TimerAdapter exposes it as ITimer where the interface is needed.
+*/
+
+template <typename ClockT>
+class BasicTimer
+{
+public:
+    typedef typename ClockT::duration duration;
+    typedef typename ClockT::time_point time_point;
+
+    explicit BasicTimer(duration timeout)
+        : m_duration(timeout), m_started(false)
+    { }
+
+    void Start()
+    {
+        m_started = true;
+        m_startTime = ClockT::now();
+    }
+
+    bool IsExpired() const
+    {
+        return !m_started || ClockT::now() - m_startTime >= m_duration;
+    }
+
+    duration TimeLeft() const
+    {
+        if (m_started)
+        {
+            const duration elapsed = ClockT::now() - m_startTime;
+            if (elapsed < m_duration)
+            {
+                return m_duration - elapsed;
+            }
+        }
+        return duration::zero();
+    }
+
+private:
+    duration m_duration;
+    bool m_started;
+    time_point m_startTime;
+};
+
+template <typename ClockT>
+class TimerAdapter: public ITimer
+{
+public:
+    explicit TimerAdapter(Duration duration)
+        : m_timer(duration)
+    { }
+
+    virtual void Start() override { m_timer.Start(); }
+    virtual bool IsExpired() const override { return m_timer.IsExpired(); }
+    virtual Duration TimeLeft() const override { return m_timer.TimeLeft(); }
+
+private:
+    BasicTimer<ClockT> m_timer;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "timer.h"
+
+/*
+ * ITime that returns a cached clock value instead of reading the clock.
+ *
+ * A ticker thread reads the clock once per resolution period and publishes it,
+ * GetCurrent is a single atomic load. The time returned lags behind the real one
+ * by up to one resolution period and never goes back.
+*/
+
+class CachedTime: public ITime
+{
+public:
+    explicit CachedTime(Duration resolution = milliseconds(1))
+        : m_resolution(resolution), m_current(Clock::now().time_since_epoch().count()), m_stop(false)
+    {
+        m_ticker = std::thread(&CachedTime::Run, this);
+    }
+
+    ~CachedTime()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_stopped.notify_one();
+        m_ticker.join();
+    }
+
+    virtual TimePoint GetCurrent() override
+    {
+        return TimePoint(Duration(m_current.load(std::memory_order_relaxed)));
+    }
+
+    Duration Resolution() const { return m_resolution; }
+
+private:
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped.wait_for(lock, m_resolution, [this]() { return m_stop; }))
+        {
+            const Duration::rep now = Clock::now().time_since_epoch().count();
+            if (now > m_current.load(std::memory_order_relaxed))
+            {
+                m_current.store(now, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    Duration m_resolution;
+    std::atomic<Duration::rep> m_current;
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    bool m_stop;
+    std::thread m_ticker;
+};
@@ -35,74 +35,14 @@ Timer can be started again any time, no metter in what state it is
 */
 
 #include <gtest/gtest.h>
-#include <chrono>
-
-using namespace std::chrono;
-typedef high_resolution_clock Clock;
-typedef Clock::duration Duration;
-typedef time_point<Clock> TimePoint;
-static const Duration s_zeroDuration(microseconds(0));
-
-class ITimer {
-public:
-  virtual ~ITimer() {}
-
-  virtual void Start() = 0;
-  virtual bool IsExpired() const = 0;
-  virtual Duration TimeLeft() const = 0;
-};
-
-class ITime
-{
-public:
-    virtual ~ITime() { }
-
-    virtual TimePoint GetCurrent() = 0;
-};
-
-class Timer: public ITimer
-{
-public:
-    Timer(ITime& time, Duration duration)
-        : m_time(time), m_duration(duration), m_started(false)
-    { }
-
-    virtual void Start() override
-    {
-        m_started = true;
-        m_startTime = m_time.GetCurrent();
-    }
-
-    virtual bool IsExpired() const override
-    {
-        return TimeElapsed() >= m_duration;
-    }
-
-    virtual Duration TimeLeft() const override
-    {
-        if (m_started && !IsExpired())
-        {
-            return m_duration - TimeElapsed();
-        }
-        return s_zeroDuration;
-    }
-
-private:
-    Duration TimeElapsed() const
-    {
-        if (m_started)
-        {
-            return m_time.GetCurrent() - m_startTime;
-        }
-        return s_zeroDuration;
-    }
-
-private:
-    ITime& m_time;
-    Duration m_duration;
-    bool m_started;
-    TimePoint m_startTime;
-};
+#include "timer.h"
+#include "timingwheel.h"
+#include "cachedtime.h"
+#include "basictimer.h"
+#include "timerservice.h"
+#include "timerset.h"
+#include <random>
+#include <thread>
 
 class FakeTime: public ITime
 {
@@ -129,6 +69,13 @@ TEST(Timer, IsExpired_NotStarted)
     ASSERT_TRUE(timer.IsExpired());
 }
 
+TEST(Timer, IsExpired_NotStartedWithDuration)
+{
+    FakeTime time;
+    Timer timer(time, seconds(1));
+    ASSERT_TRUE(timer.IsExpired());
+}
+
 TEST(Timer, IsExpired_0AndStarted)
 {
     FakeTime time;
@@ -240,3 +187,372 @@ TEST(Timer, IsExpired_TimeLeaft_AfterTimerRestart)
     ASSERT_EQ(seconds(5), timer.TimeLeft());
 }
 
+
+TEST(TimingWheel, WheelTimerIsExpiredWhenNotStarted)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    WheelTimer timer(wheel, seconds(1));
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(s_zeroDuration, timer.TimeLeft());
+}
+
+TEST(TimingWheel, WheelTimerExpiresWhenWheelAdvances)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    WheelTimer timer(wheel, seconds(5));
+    timer.Start();
+    ASSERT_FALSE(timer.IsExpired());
+    ASSERT_EQ(seconds(5), timer.TimeLeft());
+
+    time.Wait(seconds(2));
+    wheel.Advance();
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+
+    time.Wait(seconds(3));
+    wheel.Advance();
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(s_zeroDuration, timer.TimeLeft());
+}
+
+TEST(TimingWheel, WheelTimerRestart)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    WheelTimer timer(wheel, seconds(5));
+    timer.Start();
+    time.Wait(seconds(2));
+    wheel.Advance();
+
+    timer.Start();
+    ASSERT_EQ(seconds(5), timer.TimeLeft());
+    time.Wait(seconds(4));
+    wheel.Advance();
+    ASSERT_FALSE(timer.IsExpired());
+}
+
+TEST(TimingWheel, ClockSteppedBackBeforeOriginExpiresNothing)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    WheelTimer timer(wheel, seconds(1));
+    timer.Start();
+
+    time.Wait(-seconds(2));
+    wheel.Advance();
+    ASSERT_FALSE(timer.IsExpired());
+
+    time.Wait(seconds(3));
+    wheel.Advance();
+    ASSERT_TRUE(timer.IsExpired());
+}
+
+TEST(TimingWheel, ZeroDurationExpiresImmediately)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    WheelTimer timer(wheel, s_zeroDuration);
+    timer.Start();
+    ASSERT_TRUE(timer.IsExpired());
+}
+
+TEST(TimingWheel, CancelledTimerDoesNotFire)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    TimingWheel::TimerId id = wheel.Create(milliseconds(10));
+    wheel.Start(id);
+    wheel.Cancel(id);
+
+    size_t fired = 0;
+    time.Wait(seconds(1));
+    wheel.Advance([&fired](const std::vector<TimingWheel::TimerId>& expired) { fired += expired.size(); });
+    ASSERT_EQ(0, fired);
+}
+
+TEST(TimingWheel, TimersOfOneTickExpireInOneBatch)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    std::vector<TimingWheel::TimerId> ids;
+    for (int i = 0; i < 100; ++i)
+    {
+        ids.push_back(wheel.Create(milliseconds(700)));
+        wheel.Start(ids.back());
+    }
+
+    std::vector<size_t> batches;
+    time.Wait(seconds(1));
+    wheel.Advance([&batches](const std::vector<TimingWheel::TimerId>& expired) { batches.push_back(expired.size()); });
+    ASSERT_EQ(std::vector<size_t>({100}), batches);
+}
+
+TEST(TimingWheel, ExpiresEachTimerOnItsTickAcrossLevels)
+{
+    FakeTime time;
+    TimingWheel wheel(time, milliseconds(1));
+    const int durations[] = {1, 255, 256, 257, 1000, 65535, 65536, 70000, 17000000};
+    std::vector<TimingWheel::TimerId> ids;
+    for (int duration : durations)
+    {
+        ids.push_back(wheel.Create(milliseconds(duration)));
+        wheel.Start(ids.back());
+    }
+
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        const int elapsed = i ? durations[i - 1] : 0;
+        time.Wait(milliseconds(durations[i] - 1 - elapsed));
+        wheel.Advance();
+        ASSERT_TRUE(wheel.IsRunning(ids[i])) << durations[i];
+        ASSERT_EQ(milliseconds(1), wheel.TimeLeft(ids[i]));
+
+        time.Wait(milliseconds(1));
+        wheel.Advance();
+        ASSERT_FALSE(wheel.IsRunning(ids[i])) << durations[i];
+    }
+}
+
+class CountingTime: public FakeTime
+{
+public:
+    CountingTime() : m_reads(0) { }
+
+    virtual TimePoint GetCurrent() override { ++m_reads; return FakeTime::GetCurrent(); }
+
+    int Reads() const { return m_reads; }
+
+private:
+    int m_reads;
+};
+
+TEST(Timer, TimeLeft_ReadsClockOnce)
+{
+    CountingTime time;
+    Timer timer(time, seconds(5));
+    timer.Start();
+    time.Wait(seconds(2));
+
+    const int readsBefore = time.Reads();
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+    ASSERT_EQ(1, time.Reads() - readsBefore);
+}
+
+TEST(CachedTime, KeepsValueWithinResolution)
+{
+    // The ticker won't publish before the test ends.
+    CachedTime time(seconds(60));
+    const TimePoint start = time.GetCurrent();
+    ASSERT_EQ(start, time.GetCurrent());
+}
+
+TEST(CachedTime, PublishesClockWithResolution)
+{
+    CachedTime time(milliseconds(1));
+    const TimePoint start = time.GetCurrent();
+
+    std::this_thread::sleep_for(milliseconds(20));
+    ASSERT_GT(time.GetCurrent(), start);
+}
+
+TEST(CachedTime, DrivesTimer)
+{
+    CachedTime time(milliseconds(1));
+    Timer timer(time, milliseconds(10));
+    timer.Start();
+    ASSERT_FALSE(timer.IsExpired());
+
+    std::this_thread::sleep_for(milliseconds(30));
+    ASSERT_TRUE(timer.IsExpired());
+}
+
+// Clock with static now() for BasicTimer tests.
+struct StaticFakeClock
+{
+    typedef Duration duration;
+    typedef TimePoint time_point;
+
+    static time_point now() { return s_current; }
+    static void Wait(duration period) { s_current += period; }
+
+    static time_point s_current;
+};
+
+TimePoint StaticFakeClock::s_current;
+
+TEST(BasicTimer, IsExpired_NotStarted)
+{
+    BasicTimer<StaticFakeClock> timer(seconds(1));
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(s_zeroDuration, timer.TimeLeft());
+}
+
+TEST(BasicTimer, TimeLeft_Started_AfterWaiting)
+{
+    BasicTimer<StaticFakeClock> timer(seconds(10));
+    timer.Start();
+    StaticFakeClock::Wait(seconds(3));
+    ASSERT_FALSE(timer.IsExpired());
+    ASSERT_EQ(seconds(7), timer.TimeLeft());
+
+    StaticFakeClock::Wait(seconds(7));
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(s_zeroDuration, timer.TimeLeft());
+}
+
+TEST(BasicTimer, AdapterImplementsITimer)
+{
+    TimerAdapter<StaticFakeClock> adapter(seconds(5));
+    ITimer& timer = adapter;
+    ASSERT_TRUE(timer.IsExpired());
+    timer.Start();
+    StaticFakeClock::Wait(seconds(2));
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+}
+
+namespace
+{
+    template <typename TimerT>
+    size_t PollUntilExpired(TimerT& timer)
+    {
+        size_t polls = 0;
+        timer.Start();
+        while (!timer.IsExpired())
+        {
+            ++polls;
+        }
+        return polls;
+    }
+}
+
+// Run with --gtest_also_run_disabled_tests, poll counts are recorded as test properties (see --gtest_output=xml).
+// More polls per period means cheaper IsExpired.
+TEST(BasicTimer, DISABLED_BenchmarkAgainstTimer)
+{
+    const Duration period = milliseconds(200);
+
+    SystemTime time;
+    Timer timer(time, period);
+    // Read through volatile, so the compiler can't see the dynamic type and devirtualize the calls.
+    ITimer* volatile opaqueTimer = &timer;
+    const size_t virtualPolls = PollUntilExpired(*opaqueTimer);
+
+    BasicTimer<Clock> inlinedTimer(period);
+    const size_t inlinedPolls = PollUntilExpired(inlinedTimer);
+
+    RecordProperty("TimerPolls", std::to_string(virtualPolls));
+    RecordProperty("BasicTimerPolls", std::to_string(inlinedPolls));
+}
+
+namespace
+{
+    template <typename Predicate>
+    bool WaitFor(Predicate predicate, Duration timeout = seconds(5))
+    {
+        const TimePoint deadline = Clock::now() + timeout;
+        while (!predicate())
+        {
+            if (Clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        return true;
+    }
+}
+
+TEST(TimerService, CallsBackAfterDelay)
+{
+    TimerService service;
+    std::atomic<bool> fired(false);
+    const TimePoint start = Clock::now();
+    TimePoint firedAt;
+    service.Schedule(milliseconds(20), s_zeroDuration, [&]() { firedAt = Clock::now(); fired = true; });
+
+    ASSERT_TRUE(WaitFor([&]() { return fired.load(); }));
+    ASSERT_GE(firedAt - start, milliseconds(20));
+}
+
+TEST(TimerService, CancelledTimerDoesNotFire)
+{
+    TimerService service;
+    std::atomic<bool> fired(false);
+    TimerService::TimerId id = service.Schedule(milliseconds(20), s_zeroDuration, [&]() { fired = true; });
+
+    ASSERT_TRUE(service.Cancel(id));
+    ASSERT_FALSE(service.Cancel(id));
+    std::this_thread::sleep_for(milliseconds(40));
+    ASSERT_FALSE(fired);
+}
+
+TEST(TimerService, CoalescesDeadlinesWithinSlack)
+{
+    TimerService service;
+    std::atomic<int> fired(0);
+    for (int i = 0; i < 100; ++i)
+    {
+        service.Schedule(milliseconds(10) + microseconds(50 * i), milliseconds(50), [&]() { ++fired; });
+    }
+
+    ASSERT_TRUE(WaitFor([&]() { return fired == 100; }));
+    ASSERT_EQ(1, service.Dispatches());
+}
+
+TEST(TimerSet, NotStartedIsExpired)
+{
+    FakeTime time;
+    TimerSet timers;
+    TimerSet::Index index = timers.Add(seconds(1));
+
+    ASSERT_TRUE(timers.IsExpired(index, time.GetCurrent()));
+    ASSERT_EQ(s_zeroDuration, timers.TimeLeft(index, time.GetCurrent()));
+
+    std::vector<TimerSet::Index> expired;
+    timers.CollectExpired(time.GetCurrent(), expired);
+    ASSERT_EQ(std::vector<TimerSet::Index>({index}), expired);
+}
+
+TEST(TimerSet, CollectExpiredMatchesTimer)
+{
+    FakeTime time;
+    time.Wait(seconds(100));
+    TimerSet timers;
+    std::vector<std::unique_ptr<Timer>> reference;
+    std::mt19937 random(42);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const Duration duration = milliseconds(random() % 2000);
+        timers.Add(duration);
+        reference.emplace_back(new Timer(time, duration));
+    }
+
+    for (int step = 0; step < 50; ++step)
+    {
+        // Start or restart some timers, leave the rest as they are.
+        for (int i = 0; i < 100; ++i)
+        {
+            const TimerSet::Index index = random() % reference.size();
+            timers.Start(index, time.GetCurrent());
+            reference[index]->Start();
+        }
+        time.Wait(milliseconds(random() % 200));
+
+        std::vector<TimerSet::Index> expected;
+        for (TimerSet::Index index = 0; index < reference.size(); ++index)
+        {
+            if (reference[index]->IsExpired())
+            {
+                expected.push_back(index);
+            }
+            ASSERT_EQ(reference[index]->TimeLeft(), timers.TimeLeft(index, time.GetCurrent()));
+            ASSERT_EQ(reference[index]->IsExpired(), timers.IsExpired(index, time.GetCurrent()));
+        }
+
+        std::vector<TimerSet::Index> expired;
+        timers.CollectExpired(time.GetCurrent(), expired);
+        ASSERT_EQ(expected, expired);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+
+using namespace std::chrono;
+typedef high_resolution_clock Clock;
+typedef Clock::duration Duration;
+typedef time_point<Clock> TimePoint;
+static const Duration s_zeroDuration(microseconds(0));
+
+class ITimer {
+public:
+  virtual ~ITimer() {}
+
+  virtual void Start() = 0;
+  virtual bool IsExpired() const = 0;
+  virtual Duration TimeLeft() const = 0;
+};
+
+class ITime
+{
+public:
+    virtual ~ITime() { }
+
+    virtual TimePoint GetCurrent() = 0;
+};
+
+class SystemTime: public ITime
+{
+public:
+    virtual TimePoint GetCurrent() override { return Clock::now(); }
+};
+
+class Timer: public ITimer
+{
+public:
+    Timer(ITime& time, Duration duration)
+        : m_time(time), m_duration(duration), m_started(false)
+    { }
+
+    virtual void Start() override
+    {
+        m_started = true;
+        m_startTime = m_time.GetCurrent();
+    }
+
+    virtual bool IsExpired() const override
+    {
+        return !m_started || TimeElapsed() >= m_duration;
+    }
+
+    virtual Duration TimeLeft() const override
+    {
+        // One clock read for both the expiry check and the result.
+        const Duration elapsed = TimeElapsed();
+        if (m_started && elapsed < m_duration)
+        {
+            return m_duration - elapsed;
+        }
+        return s_zeroDuration;
+    }
+
+private:
+    Duration TimeElapsed() const
+    {
+        if (m_started)
+        {
+            return m_time.GetCurrent() - m_startTime;
+        }
+        return s_zeroDuration;
+    }
+
+private:
+    ITime& m_time;
+    Duration m_duration;
+    bool m_started;
+    TimePoint m_startTime;
+};
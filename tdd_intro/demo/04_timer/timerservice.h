@@ -0,0 +1,161 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "timer.h"
+
+/*
+ * Timer service calling back on deadlines.
+ *
+ * One dispatcher thread sleeps until the nearest moment some timer must fire.
+ * A timer may fire anywhere between its deadline and deadline + slack, so the dispatcher
+ * wakes up at the earliest deadline + slack and fires every timer whose deadline has come:
+ * timers expiring close together cost one wakeup instead of one each.
+ * Callbacks run on the dispatcher thread, without the service lock held.
+*/
+
+class TimerService
+{
+public:
+    typedef uint64_t TimerId;
+    typedef std::function<void()> Callback;
+
+    TimerService()
+        : m_nextId(1), m_dispatches(0), m_stop(false)
+    {
+        m_dispatcher = std::thread(&TimerService::Run, this);
+    }
+
+    ~TimerService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_changed.notify_one();
+        m_dispatcher.join();
+    }
+
+    // Calls callback once, not earlier than delay and not later than delay + slack from now.
+    TimerId Schedule(Duration delay, Duration slack, Callback callback)
+    {
+        const SteadyPoint deadline = std::chrono::steady_clock::now() + delay;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const TimerId id = m_nextId++;
+        Entry& entry = m_timers[id];
+        entry.deadline = deadline;
+        entry.latest = deadline + (slack > s_zeroDuration ? slack : s_zeroDuration);
+        entry.callback = callback;
+        m_byDeadline.insert(std::make_pair(entry.deadline, id));
+        m_byLatest.insert(std::make_pair(entry.latest, id));
+        if (m_byLatest.begin()->second == id)
+        {
+            // Dispatcher has to wake up earlier than it planned.
+            m_changed.notify_one();
+        }
+        return id;
+    }
+
+    // Returns false if the timer has already fired or was cancelled.
+    bool Cancel(TimerId id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_timers.find(id);
+        if (found == m_timers.end())
+        {
+            return false;
+        }
+        const bool wasEarliest = m_byLatest.begin()->second == id;
+        Erase(found);
+        if (wasEarliest)
+        {
+            // Dispatcher may sleep longer than it planned.
+            m_changed.notify_one();
+        }
+        return true;
+    }
+
+    // Number of wakeups that fired at least one timer.
+    size_t Dispatches() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dispatches;
+    }
+
+private:
+    typedef std::chrono::steady_clock::time_point SteadyPoint;
+
+    struct Entry
+    {
+        SteadyPoint deadline;
+        SteadyPoint latest;
+        Callback callback;
+    };
+
+    typedef std::map<TimerId, Entry> Timers;
+
+    void Erase(Timers::iterator timer)
+    {
+        m_byDeadline.erase(std::make_pair(timer->second.deadline, timer->first));
+        m_byLatest.erase(std::make_pair(timer->second.latest, timer->first));
+        m_timers.erase(timer);
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop)
+        {
+            if (m_byLatest.empty())
+            {
+                m_changed.wait(lock);
+                continue;
+            }
+            // Copied: the timer may be cancelled while the dispatcher sleeps.
+            const SteadyPoint wakeup = m_byLatest.begin()->first;
+            if (m_changed.wait_until(lock, wakeup) != std::cv_status::timeout && !m_stop)
+            {
+                // A timer was added or cancelled, the wakeup time may have changed.
+                continue;
+            }
+
+            std::vector<Callback> due;
+            const SteadyPoint now = std::chrono::steady_clock::now();
+            while (!m_byDeadline.empty() && m_byDeadline.begin()->first <= now)
+            {
+                auto timer = m_timers.find(m_byDeadline.begin()->second);
+                due.push_back(timer->second.callback);
+                Erase(timer);
+            }
+            if (due.empty())
+            {
+                continue;
+            }
+            ++m_dispatches;
+
+            lock.unlock();
+            for (const Callback& callback : due)
+            {
+                callback();
+            }
+            lock.lock();
+        }
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    Timers m_timers;
+    std::set<std::pair<SteadyPoint, TimerId>> m_byDeadline;
+    std::set<std::pair<SteadyPoint, TimerId>> m_byLatest;
+    TimerId m_nextId;
+    size_t m_dispatches;
+    bool m_stop;
+    std::thread m_dispatcher;
+};
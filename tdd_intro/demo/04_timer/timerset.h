@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "timer.h"
+
+/*
+ * Set of timers stored as structure of arrays, for "which of these deadlines are expired" queries.
+ *
+ * Start and duration ticks lie in two contiguous arrays and the expiry check is a branch-free compare.
+ * CollectExpired builds a bitmask for 64 timers at a time and turns set bits into indices.
+ * When the compiler targets AVX2 the mask is built 4 timers per compare instruction,
+ * otherwise by the scalar loop: 64 bit compares are not vectorized below SSE4.2.
+ * Semantics are the same as Timer: a timer that is not started counts as expired,
+ * TimeLeft is 0 for expired timers.
+*/
+
+class TimerSet
+{
+public:
+    typedef uint32_t Index;
+
+    // Adds a stopped timer and returns its index.
+    Index Add(Duration duration)
+    {
+        m_start.push_back(NotStarted());
+        m_duration.push_back(duration.count() > 0 ? duration.count() : 0);
+        return static_cast<Index>(m_start.size() - 1);
+    }
+
+    // Starts the timer at now, restarting it if it is running.
+    void Start(Index index, TimePoint now)
+    {
+        m_start[index] = now.time_since_epoch().count();
+    }
+
+    bool IsExpired(Index index, TimePoint now) const
+    {
+        return IsExpired(m_start[index], m_duration[index], now.time_since_epoch().count());
+    }
+
+    Duration TimeLeft(Index index, TimePoint now) const
+    {
+        if (m_start[index] == NotStarted())
+        {
+            return s_zeroDuration;
+        }
+        const Tick left = m_duration[index] - (now.time_since_epoch().count() - m_start[index]);
+        return Duration(left > 0 ? left : 0);
+    }
+
+    // Appends indices of all timers expired by now to expired, in ascending order.
+    void CollectExpired(TimePoint now, std::vector<Index>& expired) const
+    {
+        const Tick nowTicks = now.time_since_epoch().count();
+        const size_t size = m_start.size();
+        const Tick* start = m_start.data();
+        const Tick* duration = m_duration.data();
+
+        for (size_t block = 0; block < size; block += 64)
+        {
+            const size_t blockSize = size - block < 64 ? size - block : 64;
+            size_t i = 0;
+            uint64_t mask = 0;
+#if defined(__AVX2__)
+            const __m256i now4 = _mm256_set1_epi64x(nowTicks);
+            for (; i + 4 <= blockSize; i += 4)
+            {
+                const __m256i start4 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(start + block + i));
+                const __m256i duration4 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(duration + block + i));
+                // Running timers are those started after now - duration.
+                const __m256i running = _mm256_cmpgt_epi64(start4, _mm256_sub_epi64(now4, duration4));
+                mask |= static_cast<uint64_t>(~_mm256_movemask_pd(_mm256_castsi256_pd(running)) & 0xf) << i;
+            }
+#endif
+            for (; i < blockSize; ++i)
+            {
+                mask |= static_cast<uint64_t>(IsExpired(start[block + i], duration[block + i], nowTicks)) << i;
+            }
+            while (mask)
+            {
+                expired.push_back(static_cast<Index>(block + CountTrailingZeros(mask)));
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    size_t Size() const { return m_start.size(); }
+
+private:
+    typedef Duration::rep Tick;
+
+    // Not started timers start at the beginning of time, so the expiry check holds for them without a branch.
+    static Tick NotStarted() { return std::numeric_limits<Tick>::min(); }
+
+    static bool IsExpired(Tick start, Tick duration, Tick now)
+    {
+        return start <= now - duration;
+    }
+
+    static unsigned CountTrailingZeros(uint64_t mask)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+        unsigned count = 0;
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            ++count;
+        }
+        return count;
+#endif
+    }
+
+private:
+    std::vector<Tick> m_start;
+    std::vector<Tick> m_duration;
+};
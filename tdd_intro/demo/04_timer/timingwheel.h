@@ -0,0 +1,262 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "timer.h"
+
+/*
+ * Hierarchical timing wheel for huge numbers of timers.
+ *
+ * Time is split into ticks. The wheel has 4 levels of 256 slots, level N slot covers 256^N ticks,
+ * so Start, Cancel and Restart are O(1) and Advance touches only the slots of passed ticks.
+ * Timers that expire on the same tick are reported with one callback call.
+ *
+ * Timers are nodes in one array linked into slot lists by indices: 24 bytes per timer.
+ * Deadlines are rounded up to whole ticks and measured from the last Advance,
+ * so a timer expires at most one tick late.
+*/
+
+class TimingWheel
+{
+public:
+    typedef uint32_t TimerId;
+    typedef std::function<void(const std::vector<TimerId>&)> ExpiredCallback;
+
+    TimingWheel(ITime& time, Duration tick)
+        : m_time(time)
+        , m_tick(tick)
+        , m_origin(time.GetCurrent())
+        , m_current(0)
+        , m_freeList(s_nil)
+        , m_nodes(s_levels * s_slots)
+    {
+        for (uint32_t head = 0; head < s_levels * s_slots; ++head)
+        {
+            m_nodes[head].prev = head;
+            m_nodes[head].next = head;
+        }
+    }
+
+    // Creates a stopped timer. Stopped timers count as expired.
+    TimerId Create(Duration duration)
+    {
+        TimerId id;
+        if (m_freeList != s_nil)
+        {
+            id = m_freeList;
+            m_freeList = m_nodes[id].next;
+        }
+        else
+        {
+            id = static_cast<TimerId>(m_nodes.size());
+            m_nodes.push_back(Node());
+        }
+        Node& node = m_nodes[id];
+        node.prev = id;
+        node.next = id;
+        node.durationTicks = ToTicks(duration);
+        node.state = Stopped;
+        return id;
+    }
+
+    void Destroy(TimerId id)
+    {
+        Cancel(id);
+        m_nodes[id].next = m_freeList;
+        m_freeList = id;
+    }
+
+    // Starts the timer, restarting it if it is running.
+    void Start(TimerId id)
+    {
+        Cancel(id);
+        Node& node = m_nodes[id];
+        node.deadline = m_current + node.durationTicks;
+        if (node.durationTicks == 0)
+        {
+            node.state = Expired;
+            return;
+        }
+        node.state = Running;
+        Insert(id);
+    }
+
+    void Cancel(TimerId id)
+    {
+        Node& node = m_nodes[id];
+        if (node.state == Running)
+        {
+            Unlink(id);
+        }
+        node.state = Stopped;
+    }
+
+    bool IsRunning(TimerId id) const { return m_nodes[id].state == Running; }
+
+    Duration TimeLeft(TimerId id) const
+    {
+        const Node& node = m_nodes[id];
+        return node.state == Running ? m_tick * static_cast<Duration::rep>(node.deadline - m_current) : s_zeroDuration;
+    }
+
+    // Reads the clock once and expires all timers due by now, one callback call per tick.
+    // A clock stepped back before the wheel was created expires nothing.
+    void Advance(const ExpiredCallback& onExpired = ExpiredCallback())
+    {
+        const auto elapsed = (m_time.GetCurrent() - m_origin) / m_tick;
+        if (elapsed <= 0)
+        {
+            return;
+        }
+        const uint64_t target = static_cast<uint64_t>(elapsed);
+        std::vector<TimerId> expired;
+        while (m_current < target)
+        {
+            ++m_current;
+            for (uint32_t level = 1; level < s_levels && (m_current & LevelMask(level)) == 0; ++level)
+            {
+                Cascade(Head(level, SlotOf(m_current, level)));
+            }
+
+            expired.clear();
+            const uint32_t head = Head(0, SlotOf(m_current, 0));
+            while (m_nodes[head].next != head)
+            {
+                TimerId id = m_nodes[head].next;
+                Unlink(id);
+                m_nodes[id].state = Expired;
+                expired.push_back(id);
+            }
+            if (!expired.empty() && onExpired)
+            {
+                onExpired(expired);
+            }
+        }
+    }
+
+    Duration Tick() const { return m_tick; }
+
+private:
+    enum State : uint32_t
+    {
+        Stopped,
+        Running,
+        Expired
+    };
+
+    struct Node
+    {
+        uint64_t deadline = 0;
+        uint32_t prev = 0;
+        uint32_t next = 0;
+        uint32_t durationTicks = 0;
+        uint32_t state = Stopped;
+    };
+    static_assert(sizeof(Node) <= 32, "Timer must stay within 32 bytes");
+
+    static const uint32_t s_levels = 4;
+    static const uint32_t s_slotBits = 8;
+    static const uint32_t s_slots = 1u << s_slotBits;
+    static const uint32_t s_nil = ~0u;
+
+    static uint64_t LevelMask(uint32_t level) { return (uint64_t(1) << (level * s_slotBits)) - 1; }
+    static uint32_t SlotOf(uint64_t tick, uint32_t level) { return static_cast<uint32_t>(tick >> (level * s_slotBits)) & (s_slots - 1); }
+    static uint32_t Head(uint32_t level, uint32_t slot) { return level * s_slots + slot; }
+
+    uint32_t ToTicks(Duration duration) const
+    {
+        if (duration <= s_zeroDuration)
+        {
+            return 0;
+        }
+        const uint64_t ticks = static_cast<uint64_t>((duration + m_tick - Duration(1)) / m_tick);
+        return ticks > ~0u ? ~0u : static_cast<uint32_t>(ticks);
+    }
+
+    void Insert(TimerId id)
+    {
+        const uint64_t deadline = m_nodes[id].deadline;
+        const uint64_t delta = deadline - m_current;
+        uint32_t level = 0;
+        while (level + 1 < s_levels && delta > LevelMask(level + 1))
+        {
+            ++level;
+        }
+        const uint32_t head = Head(level, SlotOf(deadline, level));
+
+        Node& node = m_nodes[id];
+        node.prev = head;
+        node.next = m_nodes[head].next;
+        m_nodes[node.next].prev = id;
+        m_nodes[head].next = id;
+    }
+
+    void Unlink(TimerId id)
+    {
+        Node& node = m_nodes[id];
+        m_nodes[node.prev].next = node.next;
+        m_nodes[node.next].prev = node.prev;
+        node.prev = id;
+        node.next = id;
+    }
+
+    // Moves timers of a higher level slot down to the levels matching their remaining time.
+    void Cascade(uint32_t head)
+    {
+        while (m_nodes[head].next != head)
+        {
+            TimerId id = m_nodes[head].next;
+            Unlink(id);
+            Insert(id);
+        }
+    }
+
+private:
+    ITime& m_time;
+    Duration m_tick;
+    TimePoint m_origin;
+    uint64_t m_current;
+    TimerId m_freeList;
+    // Slot list heads come first, timer nodes follow them.
+    std::vector<Node> m_nodes;
+};
+
+// ITimer on top of TimingWheel. IsExpired and TimeLeft don't read the clock,
+// they change when the owner of the wheel calls Advance.
+class WheelTimer: public ITimer
+{
+public:
+    WheelTimer(TimingWheel& wheel, Duration duration)
+        : m_wheel(wheel), m_id(wheel.Create(duration))
+    { }
+
+    ~WheelTimer()
+    {
+        m_wheel.Destroy(m_id);
+    }
+
+    virtual void Start() override
+    {
+        m_wheel.Start(m_id);
+    }
+
+    virtual bool IsExpired() const override
+    {
+        return !m_wheel.IsRunning(m_id);
+    }
+
+    virtual Duration TimeLeft() const override
+    {
+        return m_wheel.TimeLeft(m_id);
+    }
+
+    TimingWheel::TimerId Id() const { return m_id; }
+
+private:
+    WheelTimer(const WheelTimer&);
+    WheelTimer& operator=(const WheelTimer&);
+
+private:
+    TimingWheel& m_wheel;
+    TimingWheel::TimerId m_id;
+};